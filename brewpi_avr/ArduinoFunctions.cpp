@@ -48,7 +48,6 @@ extern "C"{
 
 // Other source files, depends on your program which you need
 #include <Print.cpp>
-#include <New.cpp>
 #include <wiring.c>
 #include <wiring_digital.c>
 
@@ -59,6 +58,7 @@ extern "C"{
 //#include <wiring_pulse.c>
 //#include <wiring_shift.c>
 //#include <IPAddress.cpp>
+//#include <New.cpp> // nothing is allocated on the heap
 //#include <Stream.cpp>
 //#include <Tone.cpp>
 //#include <WMath.cpp>
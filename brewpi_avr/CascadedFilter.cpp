@@ -24,15 +24,25 @@
 #include "temperatureFormats.h"
 
 CascadedFilter::CascadedFilter() {
-	for(uint8_t i=0; i<NUM_SECTIONS; i++){
-		sections[i].setCoefficients(2); // default to a b value of 2
-	}	
+	b = 2; // default to a b value of 2
+	numSections = CASCADED_FILTER_DEFAULT_SECTIONS;
 }
 
 void CascadedFilter::setCoefficients(uint8_t bValue){
-	for(uint8_t i=0; i<NUM_SECTIONS; i++){
-		sections[i].setCoefficients(bValue);
+	b = bValue;
+}
+
+void CascadedFilter::setSections(uint8_t count){
+	if(count < 1){
+		count = 1;
+	}
+	if(count > CASCADED_FILTER_MAX_SECTIONS){
+		count = CASCADED_FILTER_MAX_SECTIONS;
 	}
+	for(uint8_t i=numSections; i<count; i++){
+		sections[i] = sections[i-1]; // start in steady state at the current output
+	}
+	numSections = count;
 }
 
 fixed7_9 CascadedFilter::add(fixed7_9 val){
@@ -43,31 +53,51 @@ fixed7_9 CascadedFilter::add(fixed7_9 val){
 }
 
 fixed7_25 CascadedFilter::addDoublePrecision(fixed7_25 val){
-	fixed7_25 input = val;
+	xv[2] = xv[1];
+	xv[1] = xv[0];
+	xv[0] = val;
+#if FIXED_FILTER_SPECIALIZED
+	// select the specialized filter once for all sections
+	switch(b){
+		case 0: return addSections<0>();
+		case 1: return addSections<1>();
+		case 2: return addSections<2>();
+		case 3: return addSections<3>();
+		case 4: return addSections<4>();
+		case 5: return addSections<5>();
+		case 6: return addSections<6>();
+	}
+#endif
 	// input is input for next section, which is the output of the previous section
-	for(uint8_t i=0; i<NUM_SECTIONS; i++){
-		input = sections[i].addDoublePrecision(input);
+	sections[0].addDoublePrecision(xv, b);
+	for(uint8_t i=1; i<numSections; i++){
+		sections[i].addDoublePrecision(sections[i-1].yv, b);
 	}
-	return input;
+	return readOutputDoublePrecision();
 }
 
 
 fixed7_9 CascadedFilter::readInput(void){
-	return sections[0].readInput(); // return input of first section
+	return xv[0]>>16; // return 16 most significant bits of most recent input
 }
 
 fixed7_25 CascadedFilter::readOutputDoublePrecision(void){
-	return sections[NUM_SECTIONS-1].readOutputDoublePrecision(); // return output of last section
+	return sections[numSections-1].readOutputDoublePrecision(); // return output of last section
 }
 
 fixed7_25 CascadedFilter::readPrevOutputDoublePrecision(void){
-	return sections[NUM_SECTIONS-1].readPrevOutputDoublePrecision(); // return previous output of last section
+	return sections[numSections-1].readPrevOutputDoublePrecision(); // return previous output of last section
 }
 
 void CascadedFilter::init(fixed7_9 val){
-	for(uint8_t i=0; i<NUM_SECTIONS; i++){
-		sections[i].init(val);
-	}
+	initDoublePrecision(((fixed7_25) val)<<16); // 16 extra bits are used in the filter for the fraction part
 }
 
-
+void CascadedFilter::initDoublePrecision(fixed7_25 val){
+	xv[0] = val;
+	xv[1] = val;
+	xv[2] = val;
+	for(uint8_t i=0; i<CASCADED_FILTER_MAX_SECTIONS; i++){
+		sections[i].initDoublePrecision(val);
+	}
+}
@@ -25,36 +25,61 @@
 #include "temperatureFormats.h"
 #include "FixedFilter.h"
 
-// Use 3 filter sections. This gives excellent filtering, without adding too much delay.
+// The number of filter sections is set per filter at run time, from 1 to CASCADED_FILTER_MAX_SECTIONS.
+// Memory for the maximum number of sections is reserved in each filter.
+// The default of 3 sections gives excellent filtering, without adding too much delay.
 // For 3 sections the stop band attenuation is 3x the single section attenuation in dB.
 // The delay is also tripled.
-#define NUM_SECTIONS 3
+#ifndef CASCADED_FILTER_MAX_SECTIONS
+#define CASCADED_FILTER_MAX_SECTIONS 4
+#endif
+#define CASCADED_FILTER_DEFAULT_SECTIONS 3
 
 class CascadedFilter{
 	public:
 	// CascadedFilter implements a filter that consists of multiple second order secions.
-	FixedFilter sections[NUM_SECTIONS];
+	// The input array of each section is the output array of the previous section, so it is not stored twice.
+	fixed7_25 xv[3]; // input array of the first section, most recent input first
+	FixedFilter sections[CASCADED_FILTER_MAX_SECTIONS];
+	uint8_t b; // coefficient of all sections, a is 2*b+4
+	uint8_t numSections; // number of sections in use
 		
 	public:
 	CascadedFilter();
 	~CascadedFilter() {}
 	void init(fixed7_9 val);
+	void initDoublePrecision(fixed7_25 val);
 	void setCoefficients(uint8_t bValue);
+	// Sections that are added start with the output of the last section, so the output does not jump
+	void setSections(uint8_t count);
+	uint8_t getSections(void){
+		return numSections;
+	}
 	fixed7_9 add(fixed7_9 val); // adds a value and returns the most recent filter output
 	fixed7_25 addDoublePrecision(fixed7_25 val);
 	fixed7_9 readInput(void); // returns the most recent filter input
 
 	fixed7_9 readOutput(void){
-		return sections[NUM_SECTIONS-1].readOutput(); // return output of last section
+		return sections[numSections-1].readOutput(); // return output of last section
 	}
 	fixed7_25 readOutputDoublePrecision(void);
 	fixed7_25 readPrevOutputDoublePrecision(void);
 	
 	fixed7_9 detectPosPeak(void){
-		return sections[NUM_SECTIONS-1].detectPosPeak(); // detect peaks in last section
+		return sections[numSections-1].detectPosPeak(); // detect peaks in last section
 	}
 	fixed7_9 detectNegPeak(void){
-		return sections[NUM_SECTIONS-1].detectNegPeak(); // detect peaks in last section
+		return sections[numSections-1].detectNegPeak(); // detect peaks in last section
+	}
+	
+	private:
+	// add the most recent input to all sections, with the coefficients as compile time constants. B must be equal to b.
+	template<uint8_t B> fixed7_25 addSections(void){
+		sections[0].addDoublePrecision<B>(xv);
+		for(uint8_t i=1; i<numSections; i++){
+			sections[i].addDoublePrecision<B>(sections[i-1].yv);
+		}
+		return readOutputDoublePrecision();
 	}
 };
 
@@ -12,6 +12,7 @@ DallasTemperature::DallasTemperature(OneWire* _oneWire)
 {
   _wire = _oneWire;
   devices = 0;
+  lastReadResult = READ_OK;
   parasite = false;
   bitResolution = 9;
   waitForConversion = true;
@@ -87,14 +88,20 @@ bool DallasTemperature::isConnected(uint8_t* deviceAddress)
 bool DallasTemperature::isConnected(uint8_t* deviceAddress, uint8_t* scratchPad)
 {
   readScratchPad(deviceAddress, scratchPad);
-  return (_wire->crc8(scratchPad, 8) == scratchPad[SCRATCHPAD_CRC]);
+  if (lastReadResult != READ_OK) return false;
+  if (_wire->crc8(scratchPad, 8) != scratchPad[SCRATCHPAD_CRC])
+  {
+    lastReadResult = READ_CRC_ERROR;
+    return false;
+  }
+  return true;
 }
 
 // read device's scratch pad
 void DallasTemperature::readScratchPad(uint8_t* deviceAddress, uint8_t* scratchPad)
 {
   // send the command
-  _wire->reset();
+  lastReadResult = _wire->reset() ? READ_OK : READ_NO_PRESENCE;
   _wire->select(deviceAddress);
   _wire->write(READSCRATCH);
 
@@ -159,7 +166,7 @@ void DallasTemperature::readScratchPad(uint8_t* deviceAddress, uint8_t* scratchP
 }
 
 // writes device's scratch pad
-void DallasTemperature::writeScratchPad(uint8_t* deviceAddress, const uint8_t* scratchPad)
+void DallasTemperature::writeScratchPad(uint8_t* deviceAddress, const uint8_t* scratchPad, bool save)
 {
   _wire->reset();
   _wire->select(deviceAddress);
@@ -169,6 +176,7 @@ void DallasTemperature::writeScratchPad(uint8_t* deviceAddress, const uint8_t* s
   // DS18S20 does not use the configuration register
   if (deviceAddress[0] != DS18S20MODEL) _wire->write(scratchPad[CONFIGURATION]); // configuration
   _wire->reset();
+  if (!save) return;
   // save the newly written values to eeprom
   _wire->write(COPYSCRATCH, parasite);
   if (parasite) delay(10); // 10ms delay
@@ -212,7 +220,7 @@ void DallasTemperature::setResolution(uint8_t newResolution)
 
 // set resolution of a device to 9, 10, 11, or 12 bits
 // if new resolution is out of range, 9 bits is used. 
-bool DallasTemperature::setResolution(uint8_t* deviceAddress, uint8_t newResolution)
+bool DallasTemperature::setResolution(uint8_t* deviceAddress, uint8_t newResolution, bool save)
 {
   ScratchPad scratchPad;
   if (isConnected(deviceAddress, scratchPad))
@@ -236,7 +244,7 @@ bool DallasTemperature::setResolution(uint8_t* deviceAddress, uint8_t newResolut
           scratchPad[CONFIGURATION] = TEMP_9_BIT;
           break;
       }
-      writeScratchPad(deviceAddress, scratchPad);
+      writeScratchPad(deviceAddress, scratchPad, save);
     }
 	return true;  // new value set
   }
@@ -296,23 +304,33 @@ void DallasTemperature::requestTemperatures()
   // ASYNC mode?
   if (false == waitForConversion) return; 
   
-  switch (bitResolution)
+  delay(millisToWaitForConversion(bitResolution));
+  return;
+}
+
+// returns the max conversion time in milliseconds for a resolution
+uint16_t DallasTemperature::millisToWaitForConversion(uint8_t resolution)
+{
+  switch (resolution)
   {
     case 9:
-      delay(94);
-      break;
+      return 94;
     case 10:
-      delay(188);
-      break;
+      return 188;
     case 11:
-      delay(375);
-      break;
+      return 375;
     case 12:
     default:
-      delay(750);
-      break;
+      return 750;
   }
-  return;
+}
+
+// returns true when a conversion started without waiting has completed
+// should only be called when nothing else has been sent on the bus since the request
+bool DallasTemperature::isConversionComplete(void)
+{
+  if (parasite) return false; // bus is held high by the master to power the devices
+  return (_wire->read_bit() == 1);
 }
 
 // sends command for one device to perform a temperature by address
@@ -364,6 +382,8 @@ bool DallasTemperature::requestTemperaturesByIndex(uint8_t deviceIndex)
   return requestTemperaturesByAddress(deviceAddress);
 }
 
+#if REQUIRESFLOAT
+
 // Fetch temperature for device index
 float DallasTemperature::getTempCByIndex(uint8_t deviceIndex)
 {
@@ -426,13 +446,58 @@ float DallasTemperature::calculateTemperature(uint8_t* deviceAddress, uint8_t* s
   return -1; //error
 }
 
+#endif
+
 // reads scratchpad and returns the temperature in degrees C
-int16_t DallasTemperature::getRawTemperature(uint8_t* deviceAddress, uint8_t* scratchPad) 
+int16_t DallasTemperature::getRawTemperature(uint8_t* /* deviceAddress */, uint8_t* scratchPad) 
 {
   int16_t rawTemperature = (((int16_t)scratchPad[TEMP_MSB]) << 8) | scratchPad[TEMP_LSB];
   return rawTemperature;
 }
 
+// reads scratchpad and returns the temperature in degrees C with 9 fraction bits
+int16_t DallasTemperature::calculateTemperatureFixed(uint8_t* deviceAddress, uint8_t* scratchPad)
+{
+  int16_t rawTemperature = getRawTemperature(deviceAddress, scratchPad);
+  int32_t temperature;
+
+  if (deviceAddress[0] == DS18S20MODEL)
+  {
+    // TEMPERATURE = TEMP_READ - 0.25 + (COUNT_PER_C - COUNT_REMAIN) / COUNT_PER_C
+    // TEMP_READ is the raw value without the 0.5C bit, see calculateTemperature()
+    uint8_t countPerC = scratchPad[COUNT_PER_C];
+    if (countPerC == 0 || scratchPad[COUNT_REMAIN] > countPerC)
+    {
+      temperature = (int32_t)rawTemperature << 8; // no valid count, use the 9 bit value
+    }
+    else
+    {
+      temperature = ((int32_t)(rawTemperature >> 1) << 9) - 128
+        + ((int16_t)(countPerC - scratchPad[COUNT_REMAIN]) << 9) / countPerC;
+    }
+  }
+  else
+  {
+    // 4 fraction bits, the lowest are undefined below 12 bit resolution
+    switch (scratchPad[CONFIGURATION])
+    {
+      case TEMP_9_BIT:
+        rawTemperature &= ~0x07;
+        break;
+      case TEMP_10_BIT:
+        rawTemperature &= ~0x03;
+        break;
+      case TEMP_11_BIT:
+        rawTemperature &= ~0x01;
+        break;
+    }
+    temperature = (int32_t)rawTemperature << 5;
+  }
+  return constrain(temperature, -32767, 32767);
+}
+
+#if REQUIRESFLOAT
+
 // returns temperature in degrees C or DEVICE_DISCONNECTED if the
 // device's scratch pad cannot be read successfully.
 // the numeric value of DEVICE_DISCONNECTED is defined in
@@ -449,6 +514,8 @@ float DallasTemperature::getTempC(uint8_t* deviceAddress)
   return DEVICE_DISCONNECTED;
 }
 
+#endif
+
 // returns temperature in degrees C or DEVICE_DISCONNECTED if the
 // device's scratch pad cannot be read successfully.
 // the numeric value of DEVICE_DISCONNECTED is defined in
@@ -465,6 +532,31 @@ int16_t DallasTemperature::getTempRaw(uint8_t* deviceAddress)
   return DEVICE_DISCONNECTED;
 }
 
+// returns temperature in raw bits from the first 2 bytes of the scratchpad.
+// A disconnected device reads as all ones, which is also a valid reading (-0.0625C),
+// so the caller has to check the value.
+int16_t DallasTemperature::getTempRawFast(uint8_t* deviceAddress)
+{
+  lastReadResult = _wire->reset() ? READ_OK : READ_NO_PRESENCE;
+  _wire->select(deviceAddress);
+  _wire->write(READSCRATCH);
+  int16_t rawTemperature = _wire->read();
+  rawTemperature |= ((int16_t)_wire->read()) << 8;
+  // the device stops sending the rest of the scratchpad at a reset
+  _wire->reset();
+  return rawTemperature;
+}
+
+// returns temperature in degrees C with 9 fraction bits or DEVICE_DISCONNECTED_FIXED
+// if the device's scratch pad cannot be read successfully.
+int16_t DallasTemperature::getTempFixed(uint8_t* deviceAddress)
+{
+  ScratchPad scratchPad;
+  if (isConnected(deviceAddress, scratchPad)) return calculateTemperatureFixed(deviceAddress, scratchPad);
+  return DEVICE_DISCONNECTED_FIXED;
+}
+
+#if REQUIRESFLOAT
 
 // returns temperature in degrees F
 // TODO: - when getTempC returns DEVICE_DISCONNECTED 
@@ -474,6 +566,8 @@ float DallasTemperature::getTempF(uint8_t* deviceAddress)
   return toFahrenheit(getTempC(deviceAddress));
 }
 
+#endif
+
 // returns true if the bus requires parasite power
 bool DallasTemperature::isParasitePowerMode(void)
 {
@@ -505,7 +599,7 @@ the next temperature conversion.
 // sets the high alarm temperature for a device in degrees celsius
 // accepts a float, but the alarm resolution will ignore anything
 // after a decimal point.  valid range is -55C - 125C
-void DallasTemperature::setHighAlarmTemp(uint8_t* deviceAddress, char celsius)
+void DallasTemperature::setHighAlarmTemp(uint8_t* deviceAddress, int8_t celsius)
 {
   // make sure the alarm temperature is within the device's range
   if (celsius > 125) celsius = 125;
@@ -522,7 +616,7 @@ void DallasTemperature::setHighAlarmTemp(uint8_t* deviceAddress, char celsius)
 // sets the low alarm temperature for a device in degreed celsius
 // accepts a float, but the alarm resolution will ignore anything
 // after a decimal point.  valid range is -55C - 125C
-void DallasTemperature::setLowAlarmTemp(uint8_t* deviceAddress, char celsius)
+void DallasTemperature::setLowAlarmTemp(uint8_t* deviceAddress, int8_t celsius)
 {
   // make sure the alarm temperature is within the device's range
   if (celsius > 125) celsius = 125;
@@ -536,21 +630,39 @@ void DallasTemperature::setLowAlarmTemp(uint8_t* deviceAddress, char celsius)
   }
 }
 
+// sets the low and high alarm temperature for a device in degrees celsius.
+// The scratchpad is not copied to EEPROM, so the window can be moved after
+// every conversion without wearing out the device. The device falls back to
+// the alarm temperatures in its EEPROM after a power cycle.
+bool DallasTemperature::setAlarmWindow(uint8_t* deviceAddress, int8_t low, int8_t high)
+{
+  // make sure the alarm temperatures are within the device's range
+  low = constrain(low, -55, 125);
+  high = constrain(high, -55, 125);
+
+  ScratchPad scratchPad;
+  if (!isConnected(deviceAddress, scratchPad)) return false;
+  scratchPad[HIGH_ALARM_TEMP] = (uint8_t)high;
+  scratchPad[LOW_ALARM_TEMP] = (uint8_t)low;
+  writeScratchPad(deviceAddress, scratchPad, false);
+  return true;
+}
+
 // returns a char with the current high alarm temperature or
 // DEVICE_DISCONNECTED for an address
-char DallasTemperature::getHighAlarmTemp(uint8_t* deviceAddress)
+int8_t DallasTemperature::getHighAlarmTemp(uint8_t* deviceAddress)
 {
   ScratchPad scratchPad;
-  if (isConnected(deviceAddress, scratchPad)) return (char)scratchPad[HIGH_ALARM_TEMP];
+  if (isConnected(deviceAddress, scratchPad)) return (int8_t)scratchPad[HIGH_ALARM_TEMP];
   return DEVICE_DISCONNECTED;
 }
 
 // returns a char with the current low alarm temperature or
 // DEVICE_DISCONNECTED for an address
-char DallasTemperature::getLowAlarmTemp(uint8_t* deviceAddress)
+int8_t DallasTemperature::getLowAlarmTemp(uint8_t* deviceAddress)
 {
   ScratchPad scratchPad;
-  if (isConnected(deviceAddress, scratchPad)) return (char)scratchPad[LOW_ALARM_TEMP];
+  if (isConnected(deviceAddress, scratchPad)) return (int8_t)scratchPad[LOW_ALARM_TEMP];
   return DEVICE_DISCONNECTED;
 }
 
@@ -578,7 +690,7 @@ void DallasTemperature::resetAlarmSearch()
 bool DallasTemperature::alarmSearch(uint8_t* newAddr)
 {
   uint8_t i;
-  char lastJunction = -1;
+  int8_t lastJunction = -1;
   uint8_t done = 1;
 
   if (alarmSearchExhausted) return false;
@@ -649,13 +761,15 @@ bool DallasTemperature::hasAlarm(uint8_t* deviceAddress)
   ScratchPad scratchPad;
   if (isConnected(deviceAddress, scratchPad))
   {
-    float temp = calculateTemperature(deviceAddress, scratchPad);
+    // the alarm registers are compared with the whole degrees of the temperature
+    int16_t rawTemperature = getRawTemperature(deviceAddress, scratchPad);
+    int8_t temp = (deviceAddress[0] == DS18S20MODEL) ? (rawTemperature >> 1) : (rawTemperature >> 4);
 
     // check low alarm
-    if ((char)temp <= (char)scratchPad[LOW_ALARM_TEMP]) return true;
+    if (temp <= (int8_t)scratchPad[LOW_ALARM_TEMP]) return true;
 
     // check high alarm
-    if ((char)temp >= (char)scratchPad[HIGH_ALARM_TEMP]) return true;
+    if (temp >= (int8_t)scratchPad[HIGH_ALARM_TEMP]) return true;
   }
 
   // no alarm
@@ -690,12 +804,14 @@ void DallasTemperature::setAlarmHandler(AlarmHandler *handler)
 }
 
 // The default alarm handler
-void DallasTemperature::defaultAlarmHandler(uint8_t* deviceAddress)
+void DallasTemperature::defaultAlarmHandler(uint8_t* /*deviceAddress*/)
 {
 }
 
 #endif
 
+#if REQUIRESFLOAT
+
 // Convert float celsius to fahrenheit
 float DallasTemperature::toFahrenheit(float celsius)
 {
@@ -708,26 +824,4 @@ float DallasTemperature::toCelsius(float fahrenheit)
   return (fahrenheit - 32) / 1.8;
 }
 
-#if REQUIRESNEW
-
-// MnetCS - Allocates memory for DallasTemperature. Allows us to instance a new object
-void* DallasTemperature::operator new(size_t size) // Implicit NSS obj size
-{
-  void * p; // void pointer
-  p = malloc(size); // Allocate memory
-  memset((DallasTemperature*)p,0,size); // Initalise memory
-
-  //!!! CANT EXPLICITLY CALL CONSTRUCTOR - workaround by using an init() methodR - workaround by using an init() method
-  return (DallasTemperature*) p; // Cast blank region to NSS pointer
-}
-
-// MnetCS 2009 -  Unallocates the memory used by this instance
-void DallasTemperature::operator delete(void* p)
-{
-  DallasTemperature* pNss =  (DallasTemperature*) p; // Cast to NSS pointer
-  pNss->~DallasTemperature(); // Destruct the object
-
-  free(p); // Free the memory
-}
-
 #endif
@@ -8,16 +8,17 @@
 // License as published by the Free Software Foundation; either
 // version 2.1 of the License, or (at your option) any later version.
 
-// set to true to include code for new and delete operators
-#ifndef REQUIRESNEW
-#define REQUIRESNEW true
-#endif
-
 // set to true to include code implementing alarm search functions
 #ifndef REQUIRESALARMS
 #define REQUIRESALARMS false
 #endif
 
+// set to true to include the functions that return a float temperature.
+// getTempRaw() and getTempFixed() do not need the floating point library.
+#ifndef REQUIRESFLOAT
+#define REQUIRESFLOAT false
+#endif
+
 #include <inttypes.h>
 #include "OneWire.h"
 
@@ -54,6 +55,13 @@
 
 // Error Codes
 #define DEVICE_DISCONNECTED -127
+// returned by getTempFixed(), outside the range of valid readings
+#define DEVICE_DISCONNECTED_FIXED (-32767-1)
+
+// Result of the last scratchpad read, see getLastReadResult()
+#define READ_OK          0
+#define READ_NO_PRESENCE 1  // no device answered the reset
+#define READ_CRC_ERROR   2  // the scratchpad CRC did not match
 
 typedef uint8_t DeviceAddress[8];
 
@@ -85,8 +93,8 @@ class DallasTemperature
   // read device's scratchpad
   void readScratchPad(uint8_t*, uint8_t*);
 
-  // write device's scratchpad
-  void writeScratchPad(uint8_t*, const uint8_t*);
+  // write device's scratchpad. The values are copied to the device's EEPROM, unless save is false
+  void writeScratchPad(uint8_t*, const uint8_t*, bool save = true);
 
   // read device's power requirements
   bool readPowerSupply(uint8_t*);
@@ -100,8 +108,9 @@ class DallasTemperature
   // returns the device resolution, 9-12
   uint8_t getResolution(uint8_t*);
 
-  // set resolution of a device to 9, 10, 11, or 12 bits
-  bool setResolution(uint8_t*, uint8_t);
+  // set resolution of a device to 9, 10, 11, or 12 bits. The resolution is copied to the device's EEPROM, unless
+  // save is false. Use false for changes at runtime, to spare the EEPROM of the device.
+  bool setResolution(uint8_t*, uint8_t, bool save = true);
   
   // sets/gets the waitForConversion flag
   // sets the value of the waitForConversion flag
@@ -116,29 +125,60 @@ class DallasTemperature
 
   bool getWaitForConversion(void);
   
+  // returns the max conversion time in milliseconds for a resolution of 9, 10, 11, or 12 bits
+  static uint16_t millisToWaitForConversion(uint8_t);
+
   // sends command for all devices on the bus to perform a temperature conversion 
   void requestTemperatures(void);
    
+  // returns true when the conversion started by requestTemperatures() has completed.
+  // Devices keep the bus low while converting. In parasite power mode this cannot
+  // be checked and false is returned, so the caller has to wait for the max conversion time.
+  bool isConversionComplete(void);
+
   // sends command for one device to perform a temperature conversion by address
   bool requestTemperaturesByAddress(uint8_t*);
 
   // sends command for one device to perform a temperature conversion by index
   bool requestTemperaturesByIndex(uint8_t);
 
+  #if REQUIRESFLOAT
+
   // returns temperature in degrees C
   float getTempC(uint8_t*);
 
   // returns temperature in degrees F
   float getTempF(uint8_t*);
 
-  // returns temperature in raw bits
-  int16_t getTempRaw(uint8_t*);  // changed return type from uint32 to int16 (Elco, BrewPi)
-
   // Get temperature for device index (slow)
   float getTempCByIndex(uint8_t);
   
   // Get temperature for device index (slow)
   float getTempFByIndex(uint8_t);
+
+  #endif
+
+  // returns temperature in raw bits
+  int16_t getTempRaw(uint8_t*);  // changed return type from uint32 to int16 (Elco, BrewPi)
+
+  // returns temperature in raw bits, reading only the first 2 bytes of the scratchpad.
+  // The read is ended early with a reset. There is no CRC, so the caller has to check the value.
+  int16_t getTempRawFast(uint8_t*);
+
+  // returns temperature in degrees C as fixed point with 9 fraction bits (fixed7_9),
+  // or DEVICE_DISCONNECTED_FIXED. Temperatures outside -64C - 64C are clamped.
+  int16_t getTempFixed(uint8_t*);
+
+  // returns the temperature in a scratchpad that was read elsewhere as fixed7_9.
+  // The CRC is not checked.
+  int16_t calculateTemperatureFixed(uint8_t*, uint8_t*);
+
+  // returns READ_OK, READ_NO_PRESENCE or READ_CRC_ERROR for the last scratchpad read.
+  // The fast read has no CRC, so it is only checked for the presence pulse.
+  uint8_t getLastReadResult(void)
+  {
+    return lastReadResult;
+  }
   
   // returns true if the bus requires parasite power
   bool isParasitePowerMode(void);
@@ -149,19 +189,23 @@ class DallasTemperature
 
   // sets the high alarm temperature for a device
   // accepts a char.  valid range is -55C - 125C
-  void setHighAlarmTemp(uint8_t*, const char);
+  void setHighAlarmTemp(uint8_t*, int8_t);
 
   // sets the low alarm temperature for a device
   // accepts a char.  valid range is -55C - 125C
-  void setLowAlarmTemp(uint8_t*, const char);
+  void setLowAlarmTemp(uint8_t*, int8_t);
+
+  // sets both alarm temperatures for a device, without copying them to its EEPROM.
+  // For alarm windows that change often. Returns false if the device did not respond.
+  bool setAlarmWindow(uint8_t*, int8_t, int8_t);
 
   // returns a signed char with the current high alarm temperature for a device
   // in the range -55C - 125C
-  char getHighAlarmTemp(uint8_t*);
+  int8_t getHighAlarmTemp(uint8_t*);
 
   // returns a signed char with the current low alarm temperature for a device
   // in the range -55C - 125C
-  char getLowAlarmTemp(uint8_t*);
+  int8_t getLowAlarmTemp(uint8_t*);
   
   // resets internal variables used for the alarm search
   void resetAlarmSearch(void);
@@ -186,20 +230,14 @@ class DallasTemperature
 
   #endif
 
+  #if REQUIRESFLOAT
+
   // convert from celsius to farenheit
   static float toFahrenheit(const float);
 
   // convert from farenheit to celsius
   static float toCelsius(const float);
 
-  #if REQUIRESNEW
-
-  // initalize memory area
-  void* operator new (unsigned int);
-
-  // delete memory reference
-  void operator delete(void*);
-  
   #endif
 
   private:
@@ -217,12 +255,17 @@ class DallasTemperature
   
   // count of devices on the bus
   uint8_t devices;
+
+  // see getLastReadResult()
+  uint8_t lastReadResult;
   
   // Take a pointer to one wire instance
   OneWire* _wire;
 
+  #if REQUIRESFLOAT
   // reads scratchpad and returns the temperature in degrees C
   float calculateTemperature(uint8_t*, uint8_t*);
+  #endif
   // same function, but for raw bits:
   int16_t getRawTemperature(uint8_t*, uint8_t*);
   
@@ -230,7 +273,7 @@ class DallasTemperature
 
   // required for alarmSearch 
   uint8_t alarmSearchAddress[8];
-  char alarmSearchJunction;
+  int8_t alarmSearchJunction;
   uint8_t alarmSearchExhausted;
 
   // the alarm handler function pointer
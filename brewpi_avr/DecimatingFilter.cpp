@@ -0,0 +1,92 @@
+/*
+ * Copyright 2012 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ * 
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "DecimatingFilter.h"
+#include <limits.h>
+
+DecimatingFilter::DecimatingFilter(){
+	differentiate = false;
+	updated = false;
+	sum = 0;
+	prevAverage = 0;
+	setDecimation(1);
+}
+
+void DecimatingFilter::init(fixed7_9 val, fixed7_25 change){
+	if(differentiate){
+		filter.initDoublePrecision(change);
+	}
+	else{
+		filter.init(val);
+	}
+	prevAverage = ((fixed7_25) val) << 16;
+	sum = 0;
+	count = 0;
+	updated = false;
+}
+
+void DecimatingFilter::setDecimation(uint8_t decimationFactor){
+	factor = (decimationFactor == 0) ? 1 : decimationFactor;
+	shift = 0;
+	while((1 << shift) < factor){
+		shift++;
+	}
+	sum = 0;
+	count = 0;
+}
+
+void DecimatingFilter::setCoefficientsForInputRate(uint8_t bValue){
+	// decimating by 2^k and lowering b by k gives the same delay. For other factors, round the factor down.
+	uint8_t rateShift = (factor == (1 << shift)) ? shift : shift - 1;
+	filter.setCoefficients((bValue > rateShift) ? bValue - rateShift : 0);
+}
+
+bool DecimatingFilter::addDoublePrecision(fixed7_25 val){
+	fixed7_25 average;
+	if(factor == 1){
+		average = val; // no pre-stage
+	}
+	else{
+		sum += val >> shift;
+		if(++count < factor){
+			updated = false;
+			return false;
+		}
+		average = (sum / factor) << shift;
+		sum = 0;
+		count = 0;
+	}
+	if(differentiate){
+		fixed7_25 change = average - prevAverage;
+		prevAverage = average;
+		average = change;
+	}
+	filter.addDoublePrecision(average);
+	updated = true;
+	return true;
+}
+
+fixed7_9 DecimatingFilter::detectPosPeak(void){
+	return updated ? filter.detectPosPeak() : INT_MIN;
+}
+
+fixed7_9 DecimatingFilter::detectNegPeak(void){
+	return updated ? filter.detectNegPeak() : INT_MIN;
+}
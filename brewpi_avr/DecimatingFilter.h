@@ -0,0 +1,92 @@
+/*
+ * Copyright 2012 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ * 
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef DECIMATINGFILTER_H_
+#define DECIMATINGFILTER_H_
+
+#include "temperatureFormats.h"
+#include "CascadedFilter.h"
+
+/* A DecimatingFilter runs a CascadedFilter once every 'factor' input samples, for filters that are so slow that
+ * running them on every sample is a waste of time.
+ * The anti-alias pre-stage averages the inputs between two filter runs (a boxcar filter), and the average is
+ * the input of the filter. The inputs are shifted right before they are added, so the sum cannot overflow.
+ * The delay of the filter in input samples is the delay for its b value times the factor, see FixedFilter.h.
+ * Each step of b doubles the delay, so setCoefficientsForInputRate() lowers b by log2(factor) to keep the delay.
+ *
+ * In differentiate mode, the input of the filter is the change of the average since the previous filter run.
+ * This is used for the slope of a signal.
+ */
+class DecimatingFilter{
+	public:
+	DecimatingFilter();
+	~DecimatingFilter() {}
+	
+	// Sets the filter and the pre-stage to val. In differentiate mode, the filter is set to change.
+	void init(fixed7_9 val, fixed7_25 change = 0);
+	
+	// Run the filter once every factor inputs, factor 1 runs it on every input. Restarts the pre-stage.
+	void setDecimation(uint8_t factor);
+	
+	void setDifferentiate(bool enabled){
+		differentiate = enabled;
+	}
+	
+	// Set b for the filter at its own, decimated, rate
+	void setCoefficients(uint8_t bValue){
+		filter.setCoefficients(bValue);
+	}
+	
+	// Set b as for a filter that runs on every input: the delay in input samples stays about the same
+	void setCoefficientsForInputRate(uint8_t bValue);
+	
+	void setSections(uint8_t count){
+		filter.setSections(count);
+	}
+	
+	// adds a value. Returns true when the filter has run and has a new output.
+	bool add(fixed7_9 val){
+		return addDoublePrecision(((fixed7_25) val) << 16);
+	}
+	bool addDoublePrecision(fixed7_25 val);
+	
+	fixed7_9 readOutput(void){
+		return filter.readOutput();
+	}
+	fixed7_25 readOutputDoublePrecision(void){
+		return filter.readOutputDoublePrecision();
+	}
+	
+	// Peaks are only reported right after the filter has run, so each peak is reported once
+	fixed7_9 detectPosPeak(void);
+	fixed7_9 detectNegPeak(void);
+	
+	private:
+	CascadedFilter filter;
+	fixed7_25 sum; // sum of the inputs since the last filter run, each shifted right by 'shift'
+	fixed7_25 prevAverage; // for differentiate mode
+	uint8_t factor;
+	uint8_t shift; // 2^shift >= factor
+	uint8_t count; // inputs in sum
+	bool differentiate;
+	bool updated; // the filter ran on the last input
+};
+
+#endif /* DECIMATINGFILTER_H_ */
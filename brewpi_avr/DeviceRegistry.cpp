@@ -0,0 +1,109 @@
+/*
+ * Copyright 2012 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ * 
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "DeviceRegistry.h"
+
+#include <avr/eeprom.h>
+#include <string.h>
+#include "OneWire.h"
+#include "TempControl.h"
+
+DeviceRegistry deviceRegistry;
+
+DeviceConfig DeviceRegistry::devices[MAX_DEVICES];
+
+void DeviceRegistry::load(void){
+	eeprom_read_block((void *) &devices, (void *) EEPROM_DEVICES_ADDRESS, sizeof(devices));
+	for(uint8_t i=0; i<MAX_DEVICES; i++){
+		// EEPROM that was never written contains 0xFF. Discard entries that are not valid.
+		if(devices[i].role > DEVICE_ROLE_SPARE || OneWire::crc8(devices[i].address, 7) != devices[i].address[7]){
+			devices[i].role = DEVICE_ROLE_NONE;
+		}
+	}
+}
+
+void DeviceRegistry::clear(void){
+	memset(devices, 0, sizeof(devices));
+	eeprom_update_block((void *) &devices, (void *) EEPROM_DEVICES_ADDRESS, sizeof(devices));
+}
+
+// write one entry to EEPROM. Only bytes that have changed are written.
+void DeviceRegistry::store(uint8_t index){
+	eeprom_update_block((void *) &devices[index], (void *) (EEPROM_DEVICES_ADDRESS + index*sizeof(DeviceConfig)), sizeof(DeviceConfig));
+}
+
+int8_t DeviceRegistry::find(const uint8_t * address){
+	for(uint8_t i=0; i<MAX_DEVICES; i++){
+		if(devices[i].role != DEVICE_ROLE_NONE && memcmp(devices[i].address, address, sizeof(DeviceAddress)) == 0){
+			return i;
+		}
+	}
+	return -1;
+}
+
+DeviceConfig * DeviceRegistry::findRole(uint8_t role, uint8_t pin){
+	for(uint8_t i=0; i<MAX_DEVICES; i++){
+		if(devices[i].role == role && devices[i].pin == pin){
+			return &devices[i];
+		}
+	}
+	return 0;
+}
+
+bool DeviceRegistry::isAvailable(const uint8_t * address, uint8_t role, uint8_t pin){
+	int8_t index = find(address);
+	if(index < 0){
+		return true; // new device
+	}
+	// Spares are free to use. A device that is registered for another pin has been moved, so that entry is outdated.
+	return devices[index].role == role || devices[index].role == DEVICE_ROLE_SPARE || devices[index].pin != pin;
+}
+
+bool DeviceRegistry::assign(const uint8_t * address, uint8_t role, uint8_t pin){
+	// the device that had this role before is missing, keep it as a spare
+	DeviceConfig * previous = findRole(role, pin);
+	if(previous != 0 && memcmp(previous->address, address, sizeof(DeviceAddress)) != 0){
+		previous->role = DEVICE_ROLE_SPARE;
+		store(previous - devices);
+	}
+	
+	int8_t index = find(address);
+	if(index < 0){
+		// new device, use a free entry or replace a spare when the table is full
+		for(uint8_t i=0; i<MAX_DEVICES; i++){
+			if(devices[i].role == DEVICE_ROLE_NONE){
+				index = i;
+				break;
+			}
+			if(devices[i].role == DEVICE_ROLE_SPARE){
+				index = i;
+			}
+		}
+		if(index < 0){
+			return false; // table is full
+		}
+	}
+	memcpy(devices[index].address, address, sizeof(DeviceAddress));
+	devices[index].family = address[0];
+	devices[index].role = role;
+	devices[index].pin = pin;
+	store(index);
+	return true;
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2012 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ * 
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef DEVICEREGISTRY_H_
+#define DEVICEREGISTRY_H_
+
+#include <inttypes.h>
+#include "DallasTemperature.h"
+
+enum deviceRoles{
+	DEVICE_ROLE_NONE, // free entry
+	DEVICE_ROLE_BEER,
+	DEVICE_ROLE_FRIDGE,
+	DEVICE_ROLE_AMBIENT,
+	DEVICE_ROLE_SPARE // known device without a function, can be taken by a sensor that lost its device
+};
+
+#define MAX_DEVICES 6
+
+// One entry of the device table, stored in EEPROM after the control constants
+struct DeviceConfig{
+	DeviceAddress address; // 1-Wire ROM code
+	uint8_t family;
+	uint8_t role;
+	uint8_t pin;
+};
+
+/* The device registry remembers which 1-Wire device fulfills which role.
+ * Sensors use the cached ROM code to address their device directly, without searching the bus.
+ * Only when the cached device is missing, the bus is searched for a replacement.
+ */
+class DeviceRegistry{
+	public:
+	DeviceRegistry(){};
+	~DeviceRegistry(){};
+	
+	static void load(void); // read device table from EEPROM
+	static void clear(void); // remove all devices and store the empty table
+	
+	// returns the device that has this role on the pin, or 0 when there is none
+	static DeviceConfig * findRole(uint8_t role, uint8_t pin);
+	
+	// returns true when a device found on pin can be used for role, because no other sensor uses it
+	static bool isAvailable(const uint8_t * address, uint8_t role, uint8_t pin);
+	
+	// store the device for this role. The device that had the role before becomes a spare.
+	static bool assign(const uint8_t * address, uint8_t role, uint8_t pin);
+	
+	private:
+	static int8_t find(const uint8_t * address);
+	static void store(uint8_t index);
+	
+	static DeviceConfig devices[MAX_DEVICES];
+};
+
+extern DeviceRegistry deviceRegistry;
+
+#endif /* DEVICEREGISTRY_H_ */
@@ -22,39 +22,18 @@
 #include <limits.h>
 #include "temperatureFormats.h"
 
-fixed7_9 FixedFilter::add(fixed7_9 val){
-	fixed7_25 returnVal = addDoublePrecision( ((fixed7_25) val) << 16);
-	return returnVal>>16;
+fixed7_25 FixedFilter::addDoublePrecision(const fixed7_25 * xv, uint8_t bValue){
+	return step(xv, bValue*2+4, bValue);
 }
 
-fixed7_25 FixedFilter::addDoublePrecision(fixed7_25 val){
-	xv[2] = xv[1];
-	xv[1] = xv[0];
-	xv[0] = val;
-	
-	yv[2] = yv[1];
-	yv[1] = yv[0];
-	
-	/* Implementation that prevents overflow as much as possible by order of operations: */
-	yv[0] = ((yv[1] - yv[2]) + yv[1]) // expected value + 1*
-	- (yv[1]>>b) + (yv[2]>>b) + // expected value +0*
-	+ (xv[0]>>a) + (xv[1]>>(a-1)) + (xv[2]>>a) // expected value +(1>>(a-2))
-	- (yv[2]>>(a-2)); // expected value -(1>>(a-2))
-	
-	return yv[0];
-}
-
-
 void FixedFilter::init(fixed7_9 val){
-		xv[0] = val;
-		xv[0] = xv[0]<<16; // 16 extra bits are used in the filter for the fraction part
+	initDoublePrecision(((fixed7_25) val)<<16); // 16 extra bits are used in the filter for the fraction part
+}
 
-		xv[1] = xv[0];
-		xv[2] = xv[0];
-	
-		yv[0] = xv[0];
-		yv[1] = xv[0];
-		yv[2] = xv[0];
+void FixedFilter::initDoublePrecision(fixed7_25 val){
+	yv[0] = val;
+	yv[1] = val;
+	yv[2] = val;
 }
 
 fixed7_9 FixedFilter::detectPosPeak(void){
@@ -67,35 +67,41 @@ H(z) = 2^-a * -------------------------------------------------
 
 #include "temperatureFormats.h"
 
+// Set to 1 to generate a filter step for each b value from 0 to 6, with the shifts as compile
+// time constants. On AVR, a 32-bit shift by a variable is a loop of single bit shifts. A shift by a constant
+// is mostly byte moves. Each b value costs extra flash. Other b values use the run-time shifts.
+// The cycles saved and the flash used are estimates from the shift sequences. They have not been measured on an AVR.
+#ifndef FIXED_FILTER_SPECIALIZED
+#define FIXED_FILTER_SPECIALIZED 1
+#endif
+
+// One section of the filter. A section only stores its output. Its input is the output of the previous
+// section, or the input of the filter for the first section, see CascadedFilter. The coefficients are
+// also stored once in the CascadedFilter, because they are the same for all sections.
 class FixedFilter{
 	public:
-		// input and output arrays
-		fixed7_25 xv[3];
+		// output array, most recent output first
 		fixed7_25 yv[3];
-		uint8_t a;
-		uint8_t b;
 
 	public:
-		FixedFilter() { setCoefficients(20); /* default to a b value of 2 */ }
+		FixedFilter() { }
 		~FixedFilter() { }
 		void init(fixed7_9 val);
+		void initDoublePrecision(fixed7_25 val);
 
-		void setCoefficients(uint8_t bValue) {
-			a = bValue*2+4;
-			b = bValue;
-		}
+		// Calculates the output for the most recent input xv[0] and returns it. xv is the input array, most recent
+		// input first, in which the new input has already been shifted in. a is 2*bValue+4.
+		fixed7_25 addDoublePrecision(const fixed7_25 * xv, uint8_t bValue);
 		
-		fixed7_9 add(fixed7_9 val); // adds a value and returns the most recent filter output
-		fixed7_25 addDoublePrecision(fixed7_25 val);
+		// Same as addDoublePrecision(xv, bValue), with the coefficients as compile time constants.
+		template<uint8_t B> fixed7_25 addDoublePrecision(const fixed7_25 * xv){
+			return step(xv, B*2+4, B);
+		}
 
 		fixed7_9 readOutput(void){
 			return yv[0]>>16; // return 16 most significant bits of most recent output
 		}
 
-		fixed7_9 readInput(void){
-			return xv[0]>>16; // return 16 most significant bits of most recent input
-		}
-
 		fixed7_25 readOutputDoublePrecision(void){
 			return yv[0];
 		}
@@ -107,6 +113,20 @@ class FixedFilter{
 		fixed7_9 detectPosPeak(void); //returns positive peak or INT_MIN when no peak has been found
 		fixed7_9 detectNegPeak(void); //returns negative peak or INT_MIN when no peak has been found
 		
+	private:
+		// One filter step. It is always inlined, so the shifts are constants when aValue and bValue are.
+		inline fixed7_25 step(const fixed7_25 * xv, uint8_t aValue, uint8_t bValue) __attribute__((always_inline)){
+			yv[2] = yv[1];
+			yv[1] = yv[0];
+			
+			/* Implementation that prevents overflow as much as possible by order of operations: */
+			yv[0] = ((yv[1] - yv[2]) + yv[1]) // expected value + 1*
+			- (yv[1]>>bValue) + (yv[2]>>bValue) + // expected value +0*
+			+ (xv[0]>>aValue) + (xv[1]>>(aValue-1)) + (xv[2]>>aValue) // expected value +(1>>(a-2))
+			- (yv[2]>>(aValue-2)); // expected value -(1>>(a-2))
+			
+			return yv[0];
+		}
 };
 
 #endif /* FixedFilter_H_ */
\ No newline at end of file
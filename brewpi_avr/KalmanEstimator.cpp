@@ -0,0 +1,65 @@
+/*
+ * Copyright 2012 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ * 
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "KalmanEstimator.h"
+#include <limits.h>
+
+KalmanEstimator::KalmanEstimator(){
+	temperature = 0;
+	rate = 0;
+	drive = 0;
+	initialized = false;
+}
+
+void KalmanEstimator::add(fixed7_9 beer, fixed7_9 fridge){
+	fixed7_25 measured = ((fixed7_25) beer) << 16;
+	if(!initialized){
+		temperature = measured;
+		rate = 0;
+		drive = 0;
+		initialized = true;
+		return;
+	}
+	// predict one second ahead
+	drive = 0;
+#if KALMAN_FRIDGE_SHIFT
+	if(fridge != INT_MIN){
+		drive = ((((fixed7_25) fridge) << 16) - temperature) >> KALMAN_FRIDGE_SHIFT;
+	}
+#endif
+	temperature += rate + drive;
+	
+	// correct with the reading
+	fixed7_25 innovation = measured - temperature;
+	temperature += innovation >> KALMAN_TEMPERATURE_SHIFT;
+	rate += innovation >> KALMAN_RATE_SHIFT;
+}
+
+fixed7_9 KalmanEstimator::readSlope(void){
+	// 2^-25 degree per second to 2^-9 degree per hour. Shift by 4 first, so the multiplication does not overflow.
+	fixed7_25 perHour = (((rate + drive) >> 4) * 3600) >> 12;
+	if(perHour > 32767){
+		return 32767;
+	}
+	if(perHour < -32767){
+		return -32767;
+	}
+	return perHour;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2012 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ * 
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef KALMANESTIMATOR_H_
+#define KALMANESTIMATOR_H_
+
+#include "temperatureFormats.h"
+
+// The gains are powers of two, like the filter coefficients: a gain of 2^-6 is a shift of 6.
+// Temperature gain. A smaller gain (larger shift) gives less noise, but a slower response.
+#ifndef KALMAN_TEMPERATURE_SHIFT
+#define KALMAN_TEMPERATURE_SHIFT 6
+#endif
+// Rate gain. Critical damping needs a rate gain of about temperature gain^2 / 2.
+#ifndef KALMAN_RATE_SHIFT
+#define KALMAN_RATE_SHIFT 13
+#endif
+// Time constant of the heat exchange between fridge and beer is 2^KALMAN_FRIDGE_SHIFT seconds (4.5 hours).
+// Set to 0 to ignore the fridge temperature.
+#ifndef KALMAN_FRIDGE_SHIFT
+#define KALMAN_FRIDGE_SHIFT 14
+#endif
+
+/* KalmanEstimator estimates the beer temperature and its rate of change from the unfiltered beer readings.
+ * The model has two states: the temperature and the rate of change that is not explained by the fridge,
+ * for example the heat of fermentation. The fridge temperature is the input: each second the beer temperature
+ * moves towards it by 1/2^KALMAN_FRIDGE_SHIFT of the difference. An error in this time constant ends up in the
+ * rate state, so it does not cause an offset.
+ * The estimator uses the steady state gains of the Kalman filter, so there is no covariance to update and each
+ * update is a few additions and shifts. For a constant rate, the estimates have no lag.
+ * Call add() once per second.
+ */
+class KalmanEstimator{
+	public:
+	KalmanEstimator();
+	~KalmanEstimator() {}
+	
+	void reset(void){ // start from the next reading
+		initialized = false;
+	}
+	
+	// Add a beer reading. The fridge temperature is INT_MIN when it is unknown.
+	void add(fixed7_9 beer, fixed7_9 fridge);
+	
+	bool isInitialized(void){
+		return initialized;
+	}
+	
+	fixed7_9 readTemperature(void){
+		return temperature >> 16;
+	}
+	
+	fixed7_9 readSlope(void); // per hour
+	
+	private:
+	fixed7_25 temperature;
+	fixed7_25 rate; // rate that is not explained by the fridge, 2^-25 degree per second
+	fixed7_25 drive; // rate caused by the fridge temperature in the last prediction
+	bool initialized;
+};
+
+#endif /* KALMANESTIMATOR_H_ */
@@ -30,54 +30,139 @@
 
 Menu menu;
 
-void Menu::pickSettingToChange(void){
+uint8_t Menu::page = MENU_NONE;
+unsigned long Menu::timer;
+uint8_t Menu::blinkPhase;
+char Menu::oldMode;
+fixed7_9 Menu::oldSetting;
+unsigned long Menu::lastUpdateTime;
+unsigned long Menu::maxLoopTime;
+
+// return values of updateBlink
+enum blinkActions{
+	BLINK_NONE,
+	BLINK_SHOW,
+	BLINK_HIDE
+};
+
+#define BLINK_RESTART 0xFF
+
+void Menu::open(void){
 	rotaryEncoder.setRange(0, 0, 2); // mode setting, beer temp, fridge temp
-	unsigned long timer = ticks.millis();
-	uint8_t blinkTimer = 0;
-	while((ticks.millis()) - timer < MENU_TIMEOUT){ // time out at 10 seconds
-		if(rotaryEncoder.changed()){
-			timer=ticks.millis();
-			blinkTimer = 0;		
-		}
-		if(blinkTimer == 0){
+	maxLoopTime = 0;
+	lastUpdateTime = ticks.micros();
+	enterPage(MENU_TOP);
+}
+
+void Menu::update(void){
+	if(page == MENU_NONE){
+		return;
+	}
+	
+	// keep track of the worst case loop time while the menu is open
+	unsigned long now = ticks.micros();
+	if(now - lastUpdateTime > maxLoopTime){
+		maxLoopTime = now - lastUpdateTime;
+	}
+	lastUpdateTime = now;
+	
+	switch(page){
+		case MENU_TOP:
+			pickSettingToChange();
+			break;
+		case MENU_MODE:
+			pickMode();
+			break;
+		case MENU_BEER_SETTING:
+			pickBeerSetting();
+			break;
+		case MENU_FRIDGE_SETTING:
+			pickFridgeSetting();
+			break;
+		default:
+			close();
+			break;
+	}
+}
+
+void Menu::enterPage(uint8_t newPage){
+	page = newPage;
+	restartBlink();
+}
+
+void Menu::close(void){
+	page = MENU_NONE;
+	display.printStationaryText(); // restore text that might have been blanked by blinking
+	display.printMode();
+	piLink.debugMessage(PSTR("Menu closed. Max loop time in menu: %lu us"), maxLoopTime);
+}
+
+bool Menu::timedOut(void){
+	return (ticks.millis() - timer) >= MENU_TIMEOUT; // time out at 10 seconds
+}
+
+// restart time out and blinking after user input
+void Menu::restartBlink(void){
+	timer = ticks.millis();
+	blinkPhase = BLINK_RESTART;
+}
+
+// returns whether the selected item should be printed or blanked in this pass, or BLINK_NONE when nothing has to be done.
+uint8_t Menu::updateBlink(void){
+	uint8_t newPhase = ((ticks.millis() - timer) % MENU_BLINK_PERIOD) >= (MENU_BLINK_PERIOD/2);
+	if(newPhase == blinkPhase){
+		return BLINK_NONE;
+	}
+	blinkPhase = newPhase;
+	return (newPhase) ? BLINK_HIDE : BLINK_SHOW;
+}
+
+void Menu::pickSettingToChange(void){
+	if(timedOut()){
+		close();
+		return;
+	}
+	if(rotaryEncoder.changed()){
+		restartBlink();
+	}
+	switch(updateBlink()){
+		case BLINK_SHOW:
 			// print all text again for blinking
-			display.printStationaryText();		
-		}
-		if(blinkTimer == 128){ // blink one of the options by overwriting it with spaces
+			display.printStationaryText();
+			break;
+		case BLINK_HIDE:
+			// blink one of the options by overwriting it with spaces
 			display.lcd.setCursor(0,rotaryEncoder.read());
 			display.lcd.print_P(PSTR("      "));
+			break;
+	}
+	if( rotaryEncoder.pushed() ){
+		rotaryEncoder.resetPushed();
+		switch(rotaryEncoder.read()){
+			case 0:
+				startPickMode();
+				break;
+			case 1:
+				// switch to beer constant, because beer setting will be set through display
+				tempControl.setMode(MODE_BEER_CONSTANT);
+				display.printMode();
+				startPickBeerSetting();
+				break;
+			case 2:
+				// switch to fridge constant, because fridge setting will be set through display
+				tempControl.setMode(MODE_FRIDGE_CONSTANT);
+				display.printMode();
+				startPickFridgeSetting();
+				break;
 		}
-		if( rotaryEncoder.pushed() ){
-			rotaryEncoder.resetPushed();
-			switch(rotaryEncoder.read()){
-				case 0:
-					pickMode();
-					return;
-				case 1:
-					// switch to beer constant, because beer setting will be set through display
-					tempControl.setMode(MODE_BEER_CONSTANT);
-					display.printMode();
-					pickBeerSetting();
-					return;
-				case 2:
-					// switch to fridge constant, because fridge setting will be set through display
-					tempControl.setMode(MODE_FRIDGE_CONSTANT);
-					display.printMode();
-					pickFridgeSetting();
-					return;
-			}
-		}
-		
-		blinkTimer++;
-		delay(3); // delay for blinking
 	}
 }
 
-void Menu::pickMode(void){
+void Menu::startPickMode(void){
 	display.printStationaryText(); // restore original text after blinking 'Mode'
-	char oldSetting = tempControl.getMode();
+	oldMode = tempControl.getMode();
 	uint8_t startValue=0;
-	switch(oldSetting){
+	switch(oldMode){
 		case 'b':
 			startValue = 0;
 			break;
@@ -89,52 +174,56 @@ void Menu::pickMode(void){
 			break;
 	}
 	rotaryEncoder.setRange(startValue, 0, 3); // toggle between beer constant, beer profile, fridge constant
+	enterPage(MENU_MODE);
+}
+
+void Menu::pickMode(void){
+	if(timedOut()){
+		// Time Out. Restore original setting
+		tempControl.setMode(oldMode);
+		close();
+		return;
+	}
 	const char lookup[] = {'b', 'f', 'p', 'o'};
-	uint8_t blinkTimer = 0;
-	unsigned long timer = ticks.millis();
-	while((ticks.millis()) - timer < MENU_TIMEOUT){ // time out at 10 seconds
-		if(rotaryEncoder.changed()){
-			timer=ticks.millis();
-			blinkTimer = 0;
-			
-			tempControl.setMode(lookup[rotaryEncoder.read()]);
-			display.printMode();
-			if( rotaryEncoder.pushed() ){
-				rotaryEncoder.resetPushed();
-				if(tempControl.getMode() ==  MODE_BEER_CONSTANT){
-					menu.pickBeerSetting();
-				}
-				else if(tempControl.getMode() == MODE_FRIDGE_CONSTANT){
-					menu.pickFridgeSetting();
-				}
-				else if(tempControl.getMode() == MODE_BEER_PROFILE){
-					piLink.printBeerAnnotation(PSTR("Changed to profile mode in menu."));
-				}
-				else if(tempControl.getMode() == MODE_OFF){
-					piLink.printBeerAnnotation(PSTR("Temp control turned off in menu."));
-				}						
+	if(rotaryEncoder.changed()){
+		restartBlink();
+		
+		tempControl.setMode(lookup[rotaryEncoder.read()]);
+		display.printMode();
+		if( rotaryEncoder.pushed() ){
+			rotaryEncoder.resetPushed();
+			if(tempControl.getMode() ==  MODE_BEER_CONSTANT){
+				startPickBeerSetting();
 				return;
 			}
-		}
-		else{
-			if(blinkTimer == 0){
-				display.printMode();
+			else if(tempControl.getMode() == MODE_FRIDGE_CONSTANT){
+				startPickFridgeSetting();
+				return;
 			}
-			if(blinkTimer == 128){
-				display.lcd.setCursor(7,0);
-				display.lcd.print_P(PSTR("             "));
-			}				
-			blinkTimer++;
-			delay(3); // delay for blinking
+			else if(tempControl.getMode() == MODE_BEER_PROFILE){
+				piLink.printBeerAnnotation(PSTR("Changed to profile mode in menu."));
+			}
+			else if(tempControl.getMode() == MODE_OFF){
+				piLink.printBeerAnnotation(PSTR("Temp control turned off in menu."));
+			}
+			close();
+			return;
 		}
 	}
-	// Time Out. Restore original setting
-	tempControl.setMode(oldSetting);
+	switch(updateBlink()){
+		case BLINK_SHOW:
+			display.printMode();
+			break;
+		case BLINK_HIDE:
+			display.lcd.setCursor(7,0);
+			display.lcd.print_P(PSTR("             "));
+			break;
+	}
 }
 
-void Menu::pickBeerSetting(void){
+void Menu::startPickBeerSetting(void){
 	display.printStationaryText(); // restore original text after blinking
-	fixed7_9 oldSetting = tempControl.getBeerSetting();
+	oldSetting = tempControl.getBeerSetting();
 	fixed7_9 startVal;
 	if(oldSetting == INT_MIN){ // previous mode was not Beer Constant / Beer Profile
 		startVal = 20*512; // start at 20 degrees Celcius
@@ -143,42 +232,43 @@ void Menu::pickBeerSetting(void){
 		startVal = oldSetting;
 	}
 	rotaryEncoder.setRange(fixedToTenths(startVal), fixedToTenths(tempControl.cc.tempSettingMin), fixedToTenths(tempControl.cc.tempSettingMax));
-	
-	uint8_t blinkTimer = 0;
-	unsigned long timer = ticks.millis();
-	while((ticks.millis()) - timer < MENU_TIMEOUT){ // time out at 10 seconds
-		if(rotaryEncoder.changed()){
-			timer=ticks.millis();
-			blinkTimer = 0;
-			
-			tempControl.setBeerTemp(tenthsToFixed(rotaryEncoder.read()));			
-			display.printBeerSet();
-			if( rotaryEncoder.pushed() ){
-				rotaryEncoder.resetPushed();
-				char tempString[9];
-				piLink.printBeerAnnotation(PSTR("Beer temp set to %s in Menu."), tempToString(tempString,tempControl.getBeerSetting(),1,9));
-				return;
-			}
-		}
-		else{
-			if(blinkTimer == 0){
-				display.printBeerSet();
-			}
-			if(blinkTimer == 128){
-				display.lcd.setCursor(12,1);
-				display.lcd.print_P(PSTR("     "));
-			}				
-			blinkTimer++;
-			delay(3); // delay for blinking
+	enterPage(MENU_BEER_SETTING);
+}
+
+void Menu::pickBeerSetting(void){
+	if(timedOut()){
+		// Time Out. Restore original setting
+		tempControl.setBeerTemp(oldSetting);
+		close();
+		return;
+	}
+	if(rotaryEncoder.changed()){
+		restartBlink();
+		
+		tempControl.setBeerTemp(tenthsToFixed(rotaryEncoder.read()));
+		display.printBeerSet();
+		if( rotaryEncoder.pushed() ){
+			rotaryEncoder.resetPushed();
+			char tempString[9];
+			piLink.printBeerAnnotation(PSTR("Beer temp set to %s in Menu."), tempToString(tempString,tempControl.getBeerSetting(),1,9));
+			close();
+			return;
 		}
 	}
-	// Time Out. Restore original setting
-	tempControl.setBeerTemp(oldSetting);
+	switch(updateBlink()){
+		case BLINK_SHOW:
+			display.printBeerSet();
+			break;
+		case BLINK_HIDE:
+			display.lcd.setCursor(12,1);
+			display.lcd.print_P(PSTR("     "));
+			break;
+	}
 }
 
-void Menu::pickFridgeSetting(void){
+void Menu::startPickFridgeSetting(void){
 	display.printStationaryText(); // restore original text after blinking
-	fixed7_9 oldSetting = tempControl.getFridgeSetting();
+	oldSetting = tempControl.getFridgeSetting();
 	fixed7_9 startVal;
 	if(oldSetting == INT_MIN){ // previous mode was not Beer Constant
 		startVal = 20*512; // start at 20 degrees Celcius
@@ -187,35 +277,36 @@ void Menu::pickFridgeSetting(void){
 		startVal = oldSetting;
 	}
 	rotaryEncoder.setRange(fixedToTenths(startVal), fixedToTenths(tempControl.cc.tempSettingMin), fixedToTenths(tempControl.cc.tempSettingMax));
-	
-	uint8_t blinkTimer = 0;
-	unsigned long timer = ticks.millis();
-	while((ticks.millis()) - timer < MENU_TIMEOUT){ // time out at 10 seconds
-		if(rotaryEncoder.changed()){
-			timer=ticks.millis();
-			blinkTimer = 0;
-			
-			tempControl.setFridgeTemp(tenthsToFixed(rotaryEncoder.read()));			
-			display.printFridgeSet();
-			if( rotaryEncoder.pushed() ){
-				rotaryEncoder.resetPushed();
-				char tempString[9];
-				piLink.printFridgeAnnotation(PSTR("Fridge temp set to %s in Menu."), tempToString(tempString,tempControl.getFridgeSetting(),1,9));
-				return;
-			}
-		}
-		else{
-			if(blinkTimer == 0){
-				display.printFridgeSet();
-			}
-			if(blinkTimer == 128){
-				display.lcd.setCursor(12,2);
-				display.lcd.print_P(PSTR("     "));
-			}				
-			blinkTimer++;
-			delay(3); // delay for blinking
+	enterPage(MENU_FRIDGE_SETTING);
+}
+
+void Menu::pickFridgeSetting(void){
+	if(timedOut()){
+		// Time Out. Restore original setting
+		tempControl.setFridgeTemp(oldSetting);
+		close();
+		return;
+	}
+	if(rotaryEncoder.changed()){
+		restartBlink();
+		
+		tempControl.setFridgeTemp(tenthsToFixed(rotaryEncoder.read()));
+		display.printFridgeSet();
+		if( rotaryEncoder.pushed() ){
+			rotaryEncoder.resetPushed();
+			char tempString[9];
+			piLink.printFridgeAnnotation(PSTR("Fridge temp set to %s in Menu."), tempToString(tempString,tempControl.getFridgeSetting(),1,9));
+			close();
+			return;
 		}
 	}
-	// Time Out. Restore original setting
-	tempControl.setFridgeTemp(oldSetting);
+	switch(updateBlink()){
+		case BLINK_SHOW:
+			display.printFridgeSet();
+			break;
+		case BLINK_HIDE:
+			display.lcd.setCursor(12,2);
+			display.lcd.print_P(PSTR("     "));
+			break;
+	}
 }
\ No newline at end of file
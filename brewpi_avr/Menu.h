@@ -21,9 +21,12 @@
 #define MENU_H_
 
 #include <inttypes.h>
+#include "temperatureFormats.h"
 
 enum menuPages{
+	MENU_NONE, // menu is closed
 	MENU_TOP,
+	MENU_MODE,
 	MENU_PROFILE_SETTING,
 	MENU_BEER_SETTING,
 	MENU_FRIDGE_SETTING,
@@ -31,16 +34,51 @@ enum menuPages{
 };
 
 #define MENU_TIMEOUT 10000ul
+// The selected item is shown for half of the blink period and hidden for the other half
+#define MENU_BLINK_PERIOD 1024ul
 
+/* The menu is a state machine that is advanced by calling update() once per pass of the main loop.
+ * None of the functions wait for user input, so temperature control and serial communication
+ * keep running while someone is using the rotary encoder.
+ */
 class Menu{
 	public:
 	Menu(){};
+	static void open(void); // open the menu at the top level
+	static void update(void); // advance the menu one step, returns immediately
+	static bool isActive(void){
+		return page != MENU_NONE;
+	}
+	// longest time in microseconds between two calls of update() since the menu was opened
+	static unsigned long getMaxLoopTime(void){
+		return maxLoopTime;
+	}
+	
+	~Menu(){};
+	
+	private:
 	static void pickSettingToChange(void);
 	static void pickMode(void);
 	static void pickBeerSetting(void);
 	static void pickFridgeSetting(void);
+
+	static void startPickMode(void);
+	static void startPickBeerSetting(void);
+	static void startPickFridgeSetting(void);
 	
-	~Menu(){};
+	static void enterPage(uint8_t newPage);
+	static void close(void);
+	static bool timedOut(void);
+	static void restartBlink(void);
+	static uint8_t updateBlink(void);
+	
+	static uint8_t page;
+	static unsigned long timer; // time of last user input, for time out and blinking
+	static uint8_t blinkPhase;
+	static char oldMode; // restored on time out
+	static fixed7_9 oldSetting; // restored on time out
+	static unsigned long lastUpdateTime;
+	static unsigned long maxLoopTime;
 };
 
 extern Menu menu;
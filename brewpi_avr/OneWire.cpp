@@ -99,101 +99,29 @@ sample code bearing this copyright.
 #include "OneWire.h"
 
 
-OneWire::OneWire(uint8_t pin)
+OneWire::OneWire(uint8_t pin) : transport(pin)
 {
-	pinMode(pin, INPUT);
-	bitmask = PIN_TO_BITMASK(pin);
-	baseReg = PIN_TO_BASEREG(pin);
 #if ONEWIRE_SEARCH
 	reset_search();
 #endif
 }
 
-
-// Perform the onewire reset function.  We will wait up to 250uS for
-// the bus to come high, if it doesn't then it is broken or shorted
-// and we return a 0;
-//
+// Perform the onewire reset function.
 // Returns 1 if a device asserted a presence pulse, 0 otherwise.
 //
 uint8_t OneWire::reset(void)
 {
-	IO_REG_TYPE mask = bitmask;
-	volatile IO_REG_TYPE *reg IO_REG_ASM = baseReg;
-	uint8_t r;
-	uint8_t retries = 125;
-
-	noInterrupts();
-	DIRECT_MODE_INPUT(reg, mask);
-	interrupts();
-	// wait until the wire is high... just in case
-	do {
-		if (--retries == 0) return 0;
-		delayMicroseconds(2);
-	} while ( !DIRECT_READ(reg, mask));
-
-	noInterrupts();
-	DIRECT_WRITE_LOW(reg, mask);
-	DIRECT_MODE_OUTPUT(reg, mask);	// drive output low
-	interrupts();
-	delayMicroseconds(500);
-	noInterrupts();
-	DIRECT_MODE_INPUT(reg, mask);	// allow it to float
-	delayMicroseconds(80);
-	r = !DIRECT_READ(reg, mask);
-	interrupts();
-	delayMicroseconds(420);
-	return r;
+	return transport.reset();
 }
 
-//
-// Write a bit. Port and bit is used to cut lookup time and provide
-// more certain timing.
-//
 void OneWire::write_bit(uint8_t v)
 {
-	IO_REG_TYPE mask=bitmask;
-	volatile IO_REG_TYPE *reg IO_REG_ASM = baseReg;
-
-	if (v & 1) {
-		noInterrupts();
-		DIRECT_WRITE_LOW(reg, mask);
-		DIRECT_MODE_OUTPUT(reg, mask);	// drive output low
-		delayMicroseconds(10);
-		DIRECT_WRITE_HIGH(reg, mask);	// drive output high
-		interrupts();
-		delayMicroseconds(55);
-	} else {
-		noInterrupts();
-		DIRECT_WRITE_LOW(reg, mask);
-		DIRECT_MODE_OUTPUT(reg, mask);	// drive output low
-		delayMicroseconds(65);
-		DIRECT_WRITE_HIGH(reg, mask);	// drive output high
-		interrupts();
-		delayMicroseconds(5);
-	}
+	transport.write_bit(v);
 }
 
-//
-// Read a bit. Port and bit is used to cut lookup time and provide
-// more certain timing.
-//
 uint8_t OneWire::read_bit(void)
 {
-	IO_REG_TYPE mask=bitmask;
-	volatile IO_REG_TYPE *reg IO_REG_ASM = baseReg;
-	uint8_t r;
-
-	noInterrupts();
-	DIRECT_MODE_OUTPUT(reg, mask);
-	DIRECT_WRITE_LOW(reg, mask);
-	delayMicroseconds(3);
-	DIRECT_MODE_INPUT(reg, mask);	// let pin float, pull up will raise
-	delayMicroseconds(10);
-	r = DIRECT_READ(reg, mask);
-	interrupts();
-	delayMicroseconds(53);
-	return r;
+	return transport.read_bit();
 }
 
 //
@@ -204,48 +132,46 @@ uint8_t OneWire::read_bit(void)
 // other mishap.
 //
 void OneWire::write(uint8_t v, uint8_t power /* = 0 */) {
-    uint8_t bitMask;
-
-    for (bitMask = 0x01; bitMask; bitMask <<= 1) {
-	OneWire::write_bit( (bitMask & v)?1:0);
-    }
-    if ( !power) {
-	noInterrupts();
-	DIRECT_MODE_INPUT(baseReg, bitmask);
-	DIRECT_WRITE_LOW(baseReg, bitmask);
-	interrupts();
-    }
+	write_bytes(&v, 1, power);
 }
 
 void OneWire::write_bytes(const uint8_t *buf, uint16_t count, bool power /* = 0 */) {
-  for (uint16_t i = 0 ; i < count ; i++)
-    write(buf[i]);
-  if (!power) {
-    noInterrupts();
-    DIRECT_MODE_INPUT(baseReg, bitmask);
-    DIRECT_WRITE_LOW(baseReg, bitmask);
-    interrupts();
-  }
+	transport.write_bytes(buf, count);
+	if ( !power) {
+		transport.release();
+	}
 }
 
 //
 // Read a byte
 //
 uint8_t OneWire::read() {
-    uint8_t bitMask;
-    uint8_t r = 0;
-
-    for (bitMask = 0x01; bitMask; bitMask <<= 1) {
-	if ( OneWire::read_bit()) r |= bitMask;
-    }
-    return r;
+	uint8_t r;
+	transport.read_bytes(&r, 1);
+	return r;
 }
 
 void OneWire::read_bytes(uint8_t *buf, uint16_t count) {
-  for (uint16_t i = 0 ; i < count ; i++)
-    buf[i] = read();
+	transport.read_bytes(buf, count);
 }
 
+#if ONEWIRE_TIMER
+bool OneWire::startTransaction(bool doReset, const uint8_t *writeBuf, uint8_t writeCount, uint8_t *readBuf, uint8_t readCount)
+{
+	return transport.startTransaction(doReset, writeBuf, writeCount, readBuf, readCount);
+}
+
+bool OneWire::transactionBusy(void)
+{
+	return OneWireTimerTransport::transactionBusy();
+}
+
+uint8_t OneWire::transactionPresence(void)
+{
+	return OneWireTimerTransport::transactionPresence();
+}
+#endif
+
 //
 // Do a ROM select
 //
@@ -268,9 +194,7 @@ void OneWire::skip()
 
 void OneWire::depower()
 {
-	noInterrupts();
-	DIRECT_MODE_INPUT(baseReg, bitmask);
-	interrupts();
+	transport.depower();
 }
 
 #if ONEWIRE_SEARCH
@@ -433,7 +357,7 @@ uint8_t OneWire::search(uint8_t *newAddr)
 // "Understanding and Using Cyclic Redundancy Checks with Maxim iButton Products"
 //
 
-#if ONEWIRE_CRC8_TABLE
+#if ONEWIRE_CRC8_TABLE == 1
 // This table comes from Dallas sample code where it is freely reusable,
 // though Copyright (C) 2000 Dallas Semiconductor Corporation
 static const uint8_t PROGMEM dscrc_table[] = {
@@ -470,6 +394,28 @@ uint8_t OneWire::crc8( uint8_t *addr, uint8_t len)
 	}
 	return crc;
 }
+#elif ONEWIRE_CRC8_TABLE == 2
+// The CRC of a byte is the XOR of the CRCs of its two nibbles, so the
+// 256 byte table above can be split in the entries for the low nibble
+// (dscrc_table[n]) and for the high nibble (dscrc_table[n << 4]).
+static const uint8_t PROGMEM dscrc_table_low[] = {
+      0, 94,188,226, 97, 63,221,131,194,156,126, 32,163,253, 31, 65};
+static const uint8_t PROGMEM dscrc_table_high[] = {
+      0,157, 35,190, 70,219,101,248,140, 17,175, 50,202, 87,233,116};
+
+//
+// Compute a Dallas Semiconductor 8 bit CRC with a table lookup per nibble.
+//
+uint8_t OneWire::crc8( uint8_t *addr, uint8_t len)
+{
+	uint8_t crc = 0;
+
+	while (len--) {
+		crc ^= *addr++;
+		crc = pgm_read_byte(dscrc_table_low + (crc & 0x0F)) ^ pgm_read_byte(dscrc_table_high + (crc >> 4));
+	}
+	return crc;
+}
 #else
 //
 // Compute a Dallas Semiconductor 8 bit CRC directly.
@@ -30,11 +30,16 @@
 #define ONEWIRE_CRC 1
 #endif
 
-// Select the table-lookup method of computing the 8-bit CRC
-// by setting this to 1.  The lookup table enlarges code size by
-// about 250 bytes.  It does NOT consume RAM (but did in very
-// old versions of OneWire).  If you disable this, a slower
-// but very compact algorithm is used.
+// Select the method of computing the 8-bit CRC. None of them
+// consume RAM, the tables are in flash (but were in RAM in very
+// old versions of OneWire).
+//   0: bitwise, very compact but about 8 times slower than the table
+//   1: 256 byte lookup table, enlarges code size by about 250 bytes
+//   2: two 16 byte lookup tables, one for each nibble. About twice
+//      the time of the full table for 32 bytes of table.
+// The variants give the same results, see test/Crc8Test.cpp. The full
+// table stays the default until the cycles and flash size of each variant
+// have been measured on the boards.
 #ifndef ONEWIRE_CRC8_TABLE
 #define ONEWIRE_CRC8_TABLE 1
 #endif
@@ -45,44 +50,31 @@
 #define ONEWIRE_CRC16 1
 #endif
 
+// Select the timer driven implementation by setting this to 1.
+// Timer1 and its compare match interrupt are used to generate the time
+// slots, so interrupts are only masked for the short parts of a slot.
+// It also allows starting a transaction and collecting the result later.
+// TempSensor uses that to read the scratchpad in the background. All other
+// functions, like reset(), read() and write(), still wait until their
+// transaction is done, with interrupts enabled.
+// AVR only. The bit-banged implementation is used when this is 0.
+#ifndef ONEWIRE_TIMER
+#define ONEWIRE_TIMER 0
+#endif
+#if ONEWIRE_TIMER && !defined(__AVR__)
+#error "The timer driven OneWire implementation is only available on AVR"
+#endif
+
 #define FALSE 0
 #define TRUE  1
 
-// Platform specific I/O definitions
-
-#if defined(__AVR__)
-#define PIN_TO_BASEREG(pin)             (portInputRegister(digitalPinToPort(pin)))
-#define PIN_TO_BITMASK(pin)             (digitalPinToBitMask(pin))
-#define IO_REG_TYPE uint8_t
-#define IO_REG_ASM asm("r30")
-#define DIRECT_READ(base, mask)         (((*(base)) & (mask)) ? 1 : 0)
-#define DIRECT_MODE_INPUT(base, mask)   ((*(base+1)) &= ~(mask))
-#define DIRECT_MODE_OUTPUT(base, mask)  ((*(base+1)) |= (mask))
-#define DIRECT_WRITE_LOW(base, mask)    ((*(base+2)) &= ~(mask))
-#define DIRECT_WRITE_HIGH(base, mask)   ((*(base+2)) |= (mask))
-
-#elif defined(__PIC32MX__)
-#include <plib.h>  // is this necessary?
-#define PIN_TO_BASEREG(pin)             (portModeRegister(digitalPinToPort(pin)))
-#define PIN_TO_BITMASK(pin)             (digitalPinToBitMask(pin))
-#define IO_REG_TYPE uint32_t
-#define IO_REG_ASM
-#define DIRECT_READ(base, mask)         (((*(base+4)) & (mask)) ? 1 : 0)  //PORTX + 0x10
-#define DIRECT_MODE_INPUT(base, mask)   ((*(base+2)) = (mask))            //TRISXSET + 0x08
-#define DIRECT_MODE_OUTPUT(base, mask)  ((*(base+1)) = (mask))            //TRISXCLR + 0x04
-#define DIRECT_WRITE_LOW(base, mask)    ((*(base+8+1)) = (mask))          //LATXCLR  + 0x24
-#define DIRECT_WRITE_HIGH(base, mask)   ((*(base+8+2)) = (mask))          //LATXSET + 0x28
-
-#else
-#error "Please define I/O register types here"
-#endif
-
+// The transport that drives the wire is picked per platform, see OneWireTransport.h
+#include "OneWireTransport.h"
 
 class OneWire
 {
   private:
-    IO_REG_TYPE bitmask;
-    volatile IO_REG_TYPE *baseReg;
+    OneWireTransport transport;
 
 #if ONEWIRE_SEARCH
     // global search state
@@ -133,6 +125,20 @@ class OneWire
     // someone shorts your bus.
     void depower(void);
 
+#if ONEWIRE_TIMER
+    // Start a transaction in the background: an optional reset, writeCount
+    // bytes from writeBuf, then readCount bytes into readBuf. The buffers
+    // must stay valid until the transaction is done. Returns false when
+    // another transaction is still running or the bus is shorted.
+    bool startTransaction(bool doReset, const uint8_t *writeBuf, uint8_t writeCount, uint8_t *readBuf, uint8_t readCount);
+
+    // Returns true while a transaction is running
+    static bool transactionBusy(void);
+
+    // Returns 1 if a device answered the reset of the last transaction
+    static uint8_t transactionPresence(void);
+#endif
+
 #if ONEWIRE_SEARCH
     // Clear the search state so that if will start from the beginning again.
     void reset_search();
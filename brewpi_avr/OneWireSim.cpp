@@ -0,0 +1,501 @@
+/*
+ * Copyright 2012 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ * 
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "OneWire.h"
+
+#if ONEWIRE_SIMULATION
+
+#include <stdlib.h>
+#include "DallasTemperature.h"
+#include "OneWireSim.h"
+#include "Ticks.h"
+
+#define SIM_READ_ROM 0x33
+#define SIM_MATCH_ROM_COMMAND 0x55
+#define SIM_SKIP_ROM 0xCC
+#define SIM_SEARCH_ROM_COMMAND 0xF0
+#define SIM_ALARM_SEARCH 0xEC
+
+OneWireSimDevice::OneWireSimDevice(uint8_t family, uint32_t serial){
+	rom[0] = family;
+	for(uint8_t i = 1; i < 7; i++){
+		rom[i] = serial & 0xFF;
+		serial >>= 8;
+	}
+	rom[7] = OneWire::crc8(rom, 7);
+	
+	// power-on state of the scratchpad: 85 degrees, alarms at 75 and 70 degrees, 12 bits
+	if(family == DS18S20MODEL){
+		scratchpad[TEMP_LSB] = 0xAA;
+		scratchpad[TEMP_MSB] = 0x00;
+		scratchpad[CONFIGURATION] = 0xFF;
+	}
+	else{
+		scratchpad[TEMP_LSB] = 0x50;
+		scratchpad[TEMP_MSB] = 0x05;
+		scratchpad[CONFIGURATION] = TEMP_12_BIT;
+	}
+	scratchpad[HIGH_ALARM_TEMP] = 75;
+	scratchpad[LOW_ALARM_TEMP] = 70;
+	scratchpad[5] = 0xFF;
+	scratchpad[COUNT_REMAIN] = 0x0C;
+	scratchpad[COUNT_PER_C] = 0x10;
+	setScratchpadCrc();
+	eeprom[0] = scratchpad[HIGH_ALARM_TEMP];
+	eeprom[1] = scratchpad[LOW_ALARM_TEMP];
+	eeprom[2] = scratchpad[CONFIGURATION];
+	
+	temp = 20 << 4;
+	connected = true;
+	parasite = false;
+	converting = false;
+	alarmFlag = false;
+	conversionEnd = 0;
+	state = SIM_WAIT_RESET;
+	nextState = SIM_WAIT_RESET;
+	rxByte = 0;
+	rxBits = 0;
+	rxCount = 0;
+	txBuffer = 0;
+	txLength = 0;
+	txBit = 0;
+	searchBit = 0;
+	searchPhase = 0;
+}
+
+uint8_t OneWireSimDevice::getResolution(void){
+	if(rom[0] == DS18S20MODEL){
+		return 9;
+	}
+	return 9 + ((scratchpad[CONFIGURATION] >> 5) & 0x03);
+}
+
+uint16_t OneWireSimDevice::getConversionTime(void){
+	switch(getResolution()){
+		case 9:
+			return (rom[0] == DS18S20MODEL) ? 750 : 94;
+		case 10:
+			return 188;
+		case 11:
+			return 375;
+		default:
+			return 750;
+	}
+}
+
+bool OneWireSimDevice::resetPulse(void){
+	if(!connected){
+		return false;
+	}
+	updateConversion();
+	state = SIM_ROM_COMMAND;
+	rxByte = 0;
+	rxBits = 0;
+	return true;
+}
+
+void OneWireSimDevice::writeSlot(uint8_t bit){
+	if(!connected){
+		return;
+	}
+	switch(state){
+		case SIM_ROM_COMMAND:
+		case SIM_MATCH_ROM:
+		case SIM_FUNCTION_COMMAND:
+		case SIM_WRITE_SCRATCHPAD:
+			receiveBit(bit);
+			break;
+		case SIM_SEARCH_ROM:
+			if(searchPhase == 2){
+				if(bit != romBit(searchBit)){
+					state = SIM_WAIT_RESET; // not in the selected branch of the search
+					break;
+				}
+				searchPhase = 0;
+				if(++searchBit == 64){
+					state = SIM_FUNCTION_COMMAND;
+				}
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+uint8_t OneWireSimDevice::readSlot(void){
+	if(!connected){
+		return 1;
+	}
+	uint8_t bit = 1;
+	switch(state){
+		case SIM_ROM_COMMAND:
+		case SIM_MATCH_ROM:
+		case SIM_FUNCTION_COMMAND:
+		case SIM_WRITE_SCRATCHPAD:
+			receiveBit(1); // a read slot looks like writing a 1 to the device
+			break;
+		case SIM_SEARCH_ROM:
+			if(searchPhase == 0){
+				bit = romBit(searchBit);
+				searchPhase = 1;
+			}
+			else if(searchPhase == 1){
+				bit = !romBit(searchBit);
+				searchPhase = 2;
+			}
+			break;
+		case SIM_TRANSMIT:
+			bit = (txBuffer[txBit>>3] >> (txBit & 7)) & 1;
+			if(++txBit == txLength*8){
+				state = nextState;
+			}
+			break;
+		case SIM_CONVERTING:
+			updateConversion();
+			bit = !converting;
+			break;
+		case SIM_READ_POWER:
+			bit = !parasite;
+			break;
+		default:
+			break;
+	}
+	return bit;
+}
+
+void OneWireSimDevice::receiveBit(uint8_t bit){
+	if(bit){
+		rxByte |= 1 << rxBits;
+	}
+	if(++rxBits == 8){
+		uint8_t value = rxByte;
+		rxByte = 0;
+		rxBits = 0;
+		byteReceived(value);
+	}
+}
+
+void OneWireSimDevice::byteReceived(uint8_t value){
+	switch(state){
+		case SIM_ROM_COMMAND:
+			switch(value){
+				case SIM_READ_ROM:
+					transmit(rom, 8, SIM_FUNCTION_COMMAND);
+					break;
+				case SIM_MATCH_ROM_COMMAND:
+					rxCount = 0;
+					state = SIM_MATCH_ROM;
+					break;
+				case SIM_SKIP_ROM:
+					state = SIM_FUNCTION_COMMAND;
+					break;
+				case SIM_ALARM_SEARCH:
+					if(!alarm()){
+						state = SIM_WAIT_RESET;
+						break;
+					}
+					// alarming devices take part in the search
+					// fall through
+				case SIM_SEARCH_ROM_COMMAND:
+					searchBit = 0;
+					searchPhase = 0;
+					state = SIM_SEARCH_ROM;
+					break;
+				default:
+					state = SIM_WAIT_RESET;
+					break;
+			}
+			break;
+		case SIM_MATCH_ROM:
+			if(value != rom[rxCount]){
+				state = SIM_WAIT_RESET;
+			}
+			else if(++rxCount == 8){
+				state = SIM_FUNCTION_COMMAND;
+			}
+			break;
+		case SIM_FUNCTION_COMMAND:
+			switch(value){
+				case STARTCONVO:
+					updateConversion();
+					converting = true;
+					conversionEnd = ticks.millis() + getConversionTime();
+					state = SIM_CONVERTING;
+					break;
+				case READSCRATCH:
+					updateConversion();
+					transmit(scratchpad, 9, SIM_WAIT_RESET);
+					break;
+				case WRITESCRATCH:
+					rxCount = 0;
+					state = SIM_WRITE_SCRATCHPAD;
+					break;
+				case COPYSCRATCH:
+					eeprom[0] = scratchpad[HIGH_ALARM_TEMP];
+					eeprom[1] = scratchpad[LOW_ALARM_TEMP];
+					eeprom[2] = scratchpad[CONFIGURATION];
+					state = SIM_WAIT_RESET; // copy is done at once, read slots return 1
+					break;
+				case RECALLSCRATCH:
+					scratchpad[HIGH_ALARM_TEMP] = eeprom[0];
+					scratchpad[LOW_ALARM_TEMP] = eeprom[1];
+					scratchpad[CONFIGURATION] = eeprom[2];
+					setScratchpadCrc();
+					state = SIM_WAIT_RESET;
+					break;
+				case READPOWERSUPPLY:
+					state = SIM_READ_POWER;
+					break;
+				default:
+					state = SIM_WAIT_RESET;
+					break;
+			}
+			break;
+		case SIM_WRITE_SCRATCHPAD:
+			if(rxCount == 0){
+				scratchpad[HIGH_ALARM_TEMP] = value;
+			}
+			else if(rxCount == 1){
+				scratchpad[LOW_ALARM_TEMP] = value;
+			}
+			else if(rom[0] != DS18S20MODEL){
+				// only the resolution bits can be written
+				scratchpad[CONFIGURATION] = (value & 0x60) | 0x1F;
+			}
+			setScratchpadCrc();
+			rxCount++;
+			if(rxCount == 3 || (rxCount == 2 && rom[0] == DS18S20MODEL)){
+				state = SIM_WAIT_RESET;
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+void OneWireSimDevice::transmit(const uint8_t * buffer, uint8_t length, uint8_t next){
+	txBuffer = buffer;
+	txLength = length;
+	txBit = 0;
+	nextState = next;
+	state = SIM_TRANSMIT;
+}
+
+// Latch the temperature in the scratchpad when the running conversion has finished
+void OneWireSimDevice::updateConversion(void){
+	if(!converting || (long)(ticks.millis() - conversionEnd) < 0){
+		return;
+	}
+	converting = false;
+	int16_t raw;
+	if(rom[0] == DS18S20MODEL){
+		// 9 bit value in half degrees, the remainder of a degree is given by COUNT_REMAIN:
+		// temperature = raw/2 - 0.25 + (16 - COUNT_REMAIN)/16
+		raw = (temp + 4) >> 3;
+		scratchpad[COUNT_REMAIN] = 12 - (temp - ((raw >> 1) << 4));
+		scratchpad[COUNT_PER_C] = 0x10;
+	}
+	else{
+		// unused low bits are undefined on the real device, here they are cleared
+		raw = temp & ~((1 << (12 - getResolution())) - 1);
+	}
+	scratchpad[TEMP_LSB] = raw & 0xFF;
+	scratchpad[TEMP_MSB] = (raw >> 8) & 0xFF;
+	setScratchpadCrc();
+	alarmFlag = (temp >> 4) >= (int8_t) scratchpad[HIGH_ALARM_TEMP] || (temp >> 4) <= (int8_t) scratchpad[LOW_ALARM_TEMP];
+}
+
+bool OneWireSimDevice::alarm(void){
+	updateConversion();
+	return alarmFlag;
+}
+
+void OneWireSimDevice::setScratchpadCrc(void){
+	scratchpad[SCRATCHPAD_CRC] = OneWire::crc8(scratchpad, 8);
+}
+
+static OneWireSimBus simBuses[ONEWIRE_SIM_MAX_PINS];
+
+OneWireSimBus::OneWireSimBus(){
+	for(uint8_t i = 0; i < ONEWIRE_SIM_MAX_DEVICES; i++){
+		devices[i] = 0;
+	}
+	presenceErrorRate = 0;
+	writeErrorRate = 0;
+	readErrorRate = 0;
+	clearStatistics();
+}
+
+OneWireSimBus * OneWireSimBus::forPin(uint8_t pin){
+	if(pin >= ONEWIRE_SIM_MAX_PINS){
+		return 0;
+	}
+	return &simBuses[pin];
+}
+
+bool OneWireSimBus::attach(OneWireSimDevice * device){
+	for(uint8_t i = 0; i < ONEWIRE_SIM_MAX_DEVICES; i++){
+		if(devices[i] == 0 || devices[i] == device){
+			devices[i] = device;
+			return true;
+		}
+	}
+	return false;
+}
+
+void OneWireSimBus::detach(OneWireSimDevice * device){
+	for(uint8_t i = 0; i < ONEWIRE_SIM_MAX_DEVICES; i++){
+		if(devices[i] == device){
+			devices[i] = 0;
+		}
+	}
+}
+
+void OneWireSimBus::clearStatistics(void){
+	resets = 0;
+	writeSlots = 0;
+	readSlots = 0;
+	injectedErrors = 0;
+	busTime = 0;
+}
+
+// returns true with a chance of rate/65536
+bool OneWireSimBus::injectError(uint16_t rate){
+	if(rate == 0){
+		return false;
+	}
+	uint16_t r = ((rand() & 0xFF) << 8) | (rand() & 0xFF);
+	if(r < rate){
+		injectedErrors++;
+		return true;
+	}
+	return false;
+}
+
+uint8_t OneWireSimBus::reset(void){
+	uint8_t presence = 0;
+	resets++;
+	busTime += ONEWIRE_SIM_RESET_TIME;
+	for(uint8_t i = 0; i < ONEWIRE_SIM_MAX_DEVICES; i++){
+		if(devices[i] && devices[i]->resetPulse()){
+			presence = 1;
+		}
+	}
+	if(presence && injectError(presenceErrorRate)){
+		presence = 0;
+	}
+	return presence;
+}
+
+void OneWireSimBus::write_bit(uint8_t v){
+	v &= 1;
+	writeSlots++;
+	busTime += v ? ONEWIRE_SIM_WRITE_ONE_TIME : ONEWIRE_SIM_WRITE_ZERO_TIME;
+	if(injectError(writeErrorRate)){
+		v = !v;
+	}
+	for(uint8_t i = 0; i < ONEWIRE_SIM_MAX_DEVICES; i++){
+		if(devices[i]){
+			devices[i]->writeSlot(v);
+		}
+	}
+}
+
+uint8_t OneWireSimBus::read_bit(void){
+	uint8_t r = 1;
+	readSlots++;
+	busTime += ONEWIRE_SIM_READ_TIME;
+	for(uint8_t i = 0; i < ONEWIRE_SIM_MAX_DEVICES; i++){
+		if(devices[i]){
+			r &= devices[i]->readSlot(); // wired-AND
+		}
+	}
+	if(injectError(readErrorRate)){
+		r = !r;
+	}
+	return r;
+}
+
+void OneWireSimTransport::write_bytes(const uint8_t *buf, uint16_t count){
+	for(uint16_t i = 0; i < count; i++){
+		for(uint8_t bitMask = 0x01; bitMask; bitMask <<= 1){
+			write_bit((buf[i] & bitMask) ? 1 : 0);
+		}
+	}
+}
+
+void OneWireSimTransport::read_bytes(uint8_t *buf, uint16_t count){
+	for(uint16_t i = 0; i < count; i++){
+		uint8_t r = 0;
+		for(uint8_t bitMask = 0x01; bitMask; bitMask <<= 1){
+			if(read_bit()){
+				r |= bitMask;
+			}
+		}
+		buf[i] = r;
+	}
+}
+
+bool OneWireLockStep::addPin(uint8_t pin){
+	OneWireSimBus * bus = OneWireSimBus::forPin(pin);
+	if(bus == 0 || numPins >= ONEWIRE_MAX_LOCKSTEP_PINS){
+		return false;
+	}
+	for(uint8_t i = 0; i < numPins; i++){
+		if(buses[i] == bus){
+			return false;
+		}
+	}
+	buses[numPins++] = bus;
+	return true;
+}
+
+uint8_t OneWireLockStep::reset(void){
+	uint8_t presence = 0;
+	for(uint8_t i = 0; i < numPins; i++){
+		if(buses[i]->reset()){
+			presence |= 1 << i;
+		}
+	}
+	return presence;
+}
+
+void OneWireLockStep::write(const uint8_t *data){
+	for(uint8_t bitMask = 0x01; bitMask; bitMask <<= 1){
+		for(uint8_t i = 0; i < numPins; i++){
+			buses[i]->write_bit((data[i] & bitMask) ? 1 : 0);
+		}
+	}
+}
+
+void OneWireLockStep::read(uint8_t *data){
+	for(uint8_t i = 0; i < numPins; i++){
+		data[i] = 0;
+	}
+	for(uint8_t bitMask = 0x01; bitMask; bitMask <<= 1){
+		for(uint8_t i = 0; i < numPins; i++){
+			if(buses[i]->read_bit()){
+				data[i] |= bitMask;
+			}
+		}
+	}
+}
+
+#endif // ONEWIRE_SIMULATION
@@ -0,0 +1,223 @@
+/*
+ * Copyright 2012 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ * 
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ONEWIRESIM_H_
+#define ONEWIRESIM_H_
+
+#include <inttypes.h>
+
+// Number of pins that can have a simulated bus
+#define ONEWIRE_SIM_MAX_PINS 32
+// Number of devices on one simulated bus
+#define ONEWIRE_SIM_MAX_DEVICES 8
+
+// Bus time in microseconds spent on each kind of slot, as timed by OneWirePinTransport
+#define ONEWIRE_SIM_RESET_TIME 1000
+#define ONEWIRE_SIM_WRITE_ONE_TIME 65
+#define ONEWIRE_SIM_WRITE_ZERO_TIME 70
+#define ONEWIRE_SIM_READ_TIME 66
+
+enum oneWireSimDeviceStates{
+	SIM_WAIT_RESET, // not selected, slots are ignored until the next reset
+	SIM_ROM_COMMAND,
+	SIM_MATCH_ROM,
+	SIM_SEARCH_ROM,
+	SIM_FUNCTION_COMMAND,
+	SIM_TRANSMIT,
+	SIM_WRITE_SCRATCHPAD,
+	SIM_CONVERTING,
+	SIM_READ_POWER
+};
+
+/* A simulated DS18B20, DS1822 or DS18S20 temperature sensor.
+ * The device follows the 1-Wire protocol slot by slot: ROM commands (read, match, skip, search and
+ * alarm search), convert, read/write/copy/recall scratchpad and read power supply.
+ * Conversions take as long as on the real device for the configured resolution, using millis().
+ * A device that is disconnected does not answer resets and reads as all ones, also halfway a transaction.
+ */
+class OneWireSimDevice{
+	public:
+	OneWireSimDevice(uint8_t family, uint32_t serial);
+	
+	// temperature in 1/16 degree Celsius, picked up by the next conversion
+	void setTemperature(int16_t temperature){
+		temp = temperature;
+	}
+	
+	void setConnected(bool isConnected){
+		connected = isConnected;
+		if(!connected){
+			state = SIM_WAIT_RESET;
+		}
+	}
+	
+	void setParasite(bool isParasite){
+		parasite = isParasite;
+	}
+	
+	bool isConnected(void){
+		return connected;
+	}
+	
+	const uint8_t * getAddress(void){
+		return rom;
+	}
+	
+	// resolution in bits (9-12)
+	uint8_t getResolution(void);
+	
+	// conversion time in milliseconds for the current resolution
+	uint16_t getConversionTime(void);
+	
+	// slot handlers, called by the bus for every slot on the wire
+	bool resetPulse(void);
+	void writeSlot(uint8_t bit);
+	uint8_t readSlot(void);
+	
+	private:
+	void receiveBit(uint8_t bit);
+	void byteReceived(uint8_t value);
+	void transmit(const uint8_t * buffer, uint8_t length, uint8_t nextState);
+	void updateConversion(void);
+	bool alarm(void);
+	void setScratchpadCrc(void);
+	uint8_t romBit(uint8_t bitNr){
+		return (rom[bitNr>>3] >> (bitNr & 7)) & 1;
+	}
+	
+	uint8_t rom[8];
+	uint8_t scratchpad[9];
+	uint8_t eeprom[3]; // TH, TL and configuration register
+	int16_t temp;
+	bool connected;
+	bool parasite;
+	bool converting;
+	bool alarmFlag;
+	unsigned long conversionEnd; // in milliseconds
+	
+	uint8_t state;
+	uint8_t nextState; // state after a transmit
+	uint8_t rxByte;
+	uint8_t rxBits;
+	uint8_t rxCount;
+	const uint8_t * txBuffer;
+	uint8_t txLength;
+	uint8_t txBit;
+	uint8_t searchBit;
+	uint8_t searchPhase; // 0: send bit, 1: send complement, 2: receive direction
+};
+
+/* A simulated 1-Wire bus with the devices attached to one pin.
+ * The wire is a wired-AND: a read slot returns 0 when any device pulls it low.
+ * Bus errors can be injected as a chance per 65536 slots: a missed presence pulse, a flipped bit
+ * in a write slot or a flipped bit in a read slot. Flipped read bits show up as CRC errors.
+ * The bus keeps statistics and counts the time the slots would take on a real wire.
+ */
+class OneWireSimBus{
+	public:
+	OneWireSimBus();
+	
+	// returns the bus for a pin, or 0 if the pin number is out of range.
+	static OneWireSimBus * forPin(uint8_t pin);
+	
+	bool attach(OneWireSimDevice * device);
+	void detach(OneWireSimDevice * device);
+	
+	void setErrorRates(uint16_t presence, uint16_t write, uint16_t read){
+		presenceErrorRate = presence;
+		writeErrorRate = write;
+		readErrorRate = read;
+	}
+	
+	uint8_t reset(void);
+	void write_bit(uint8_t v);
+	uint8_t read_bit(void);
+	
+	void clearStatistics(void);
+	
+	unsigned long resets;
+	unsigned long writeSlots;
+	unsigned long readSlots;
+	unsigned long injectedErrors;
+	unsigned long busTime; // in microseconds
+	
+	private:
+	bool injectError(uint16_t rate);
+	
+	OneWireSimDevice * devices[ONEWIRE_SIM_MAX_DEVICES];
+	uint16_t presenceErrorRate;
+	uint16_t writeErrorRate;
+	uint16_t readErrorRate;
+};
+
+// Transport for OneWire that runs on a simulated bus, see OneWireTransport.h
+class OneWireSimTransport{
+	public:
+	OneWireSimTransport(uint8_t pin) : bus(OneWireSimBus::forPin(pin)){}
+	
+	uint8_t reset(void){
+		return bus ? bus->reset() : 0;
+	}
+	
+	void write_bit(uint8_t v){
+		if(bus){
+			bus->write_bit(v);
+		}
+	}
+	
+	uint8_t read_bit(void){
+		return bus ? bus->read_bit() : 1;
+	}
+	
+	void write_bytes(const uint8_t *buf, uint16_t count);
+	void read_bytes(uint8_t *buf, uint16_t count);
+	
+	// the simulated pin is never driven outside a slot
+	void release(void){}
+	void depower(void){}
+	
+	private:
+	OneWireSimBus * bus;
+};
+
+// Runs slots on several simulated buses, see OneWireLockStep in OneWireTransport.h.
+// The buses are independent, so any pins can be combined.
+class OneWireLockStep{
+	public:
+	OneWireLockStep(void){
+		numPins = 0;
+	}
+	
+	bool addPin(uint8_t pin);
+	
+	uint8_t getNumPins(void){
+		return numPins;
+	}
+	
+	uint8_t reset(void);
+	void write(const uint8_t *data);
+	void read(uint8_t *data);
+	
+	private:
+	OneWireSimBus * buses[ONEWIRE_MAX_LOCKSTEP_PINS];
+	uint8_t numPins;
+};
+
+#endif /* ONEWIRESIM_H_ */
@@ -0,0 +1,558 @@
+/*
+The bit level transports used by OneWire. The pin and timer transports were
+split out of OneWire.cpp, see there for the copyright and license.
+*/
+
+#include "OneWire.h"
+
+#if !ONEWIRE_SIMULATION
+
+OneWirePinTransport::OneWirePinTransport(uint8_t pin)
+{
+	pinMode(pin, INPUT);
+	bitmask = PIN_TO_BITMASK(pin);
+	baseReg = PIN_TO_BASEREG(pin);
+}
+
+// Perform the onewire reset function.  We will wait up to 250uS for
+// the bus to come high, if it doesn't then it is broken or shorted
+// and we return a 0;
+//
+// Returns 1 if a device asserted a presence pulse, 0 otherwise.
+//
+uint8_t OneWirePinTransport::reset(void)
+{
+	IO_REG_TYPE mask = bitmask;
+	volatile IO_REG_TYPE *reg IO_REG_ASM = baseReg;
+	uint8_t r;
+	uint8_t retries = 125;
+
+	noInterrupts();
+	DIRECT_MODE_INPUT(reg, mask);
+	interrupts();
+	// wait until the wire is high... just in case
+	do {
+		if (--retries == 0) return 0;
+		delayMicroseconds(2);
+	} while ( !DIRECT_READ(reg, mask));
+
+	noInterrupts();
+	DIRECT_WRITE_LOW(reg, mask);
+	DIRECT_MODE_OUTPUT(reg, mask);	// drive output low
+	interrupts();
+	delayMicroseconds(500);
+	noInterrupts();
+	DIRECT_MODE_INPUT(reg, mask);	// allow it to float
+	delayMicroseconds(80);
+	r = !DIRECT_READ(reg, mask);
+	interrupts();
+	delayMicroseconds(420);
+	return r;
+}
+
+//
+// Write a bit. Port and bit is used to cut lookup time and provide
+// more certain timing.
+//
+void OneWirePinTransport::write_bit(uint8_t v)
+{
+	IO_REG_TYPE mask=bitmask;
+	volatile IO_REG_TYPE *reg IO_REG_ASM = baseReg;
+
+	if (v & 1) {
+		noInterrupts();
+		DIRECT_WRITE_LOW(reg, mask);
+		DIRECT_MODE_OUTPUT(reg, mask);	// drive output low
+		delayMicroseconds(10);
+		DIRECT_WRITE_HIGH(reg, mask);	// drive output high
+		interrupts();
+		delayMicroseconds(55);
+	} else {
+		noInterrupts();
+		DIRECT_WRITE_LOW(reg, mask);
+		DIRECT_MODE_OUTPUT(reg, mask);	// drive output low
+		delayMicroseconds(65);
+		DIRECT_WRITE_HIGH(reg, mask);	// drive output high
+		interrupts();
+		delayMicroseconds(5);
+	}
+}
+
+//
+// Read a bit. Port and bit is used to cut lookup time and provide
+// more certain timing.
+//
+uint8_t OneWirePinTransport::read_bit(void)
+{
+	IO_REG_TYPE mask=bitmask;
+	volatile IO_REG_TYPE *reg IO_REG_ASM = baseReg;
+	uint8_t r;
+
+	noInterrupts();
+	DIRECT_MODE_OUTPUT(reg, mask);
+	DIRECT_WRITE_LOW(reg, mask);
+	delayMicroseconds(3);
+	DIRECT_MODE_INPUT(reg, mask);	// let pin float, pull up will raise
+	delayMicroseconds(10);
+	r = DIRECT_READ(reg, mask);
+	interrupts();
+	delayMicroseconds(53);
+	return r;
+}
+
+void OneWirePinTransport::write_bytes(const uint8_t *buf, uint16_t count)
+{
+	for (uint16_t i = 0 ; i < count ; i++) {
+		uint8_t v = buf[i];
+		for (uint8_t bitMask = 0x01; bitMask; bitMask <<= 1) {
+			write_bit( (bitMask & v)?1:0);
+		}
+	}
+}
+
+void OneWirePinTransport::read_bytes(uint8_t *buf, uint16_t count)
+{
+	for (uint16_t i = 0 ; i < count ; i++) {
+		uint8_t r = 0;
+		for (uint8_t bitMask = 0x01; bitMask; bitMask <<= 1) {
+			if ( read_bit()) r |= bitMask;
+		}
+		buf[i] = r;
+	}
+}
+
+void OneWirePinTransport::release(void)
+{
+	noInterrupts();
+	DIRECT_MODE_INPUT(baseReg, bitmask);
+	DIRECT_WRITE_LOW(baseReg, bitmask);
+	interrupts();
+}
+
+void OneWirePinTransport::depower(void)
+{
+	noInterrupts();
+	DIRECT_MODE_INPUT(baseReg, bitmask);
+	interrupts();
+}
+
+OneWireLockStep::OneWireLockStep(void)
+{
+	allMask = 0;
+	baseReg = 0;
+	numPins = 0;
+}
+
+bool OneWireLockStep::addPin(uint8_t pin)
+{
+	IO_REG_TYPE mask = PIN_TO_BITMASK(pin);
+	volatile IO_REG_TYPE *reg = PIN_TO_BASEREG(pin);
+	if (numPins >= ONEWIRE_MAX_LOCKSTEP_PINS || (numPins > 0 && reg != baseReg) || (allMask & mask)) {
+		return false;
+	}
+	pinMode(pin, INPUT);
+	masks[numPins++] = mask;
+	allMask |= mask;
+	baseReg = reg;
+	return true;
+}
+
+uint8_t OneWireLockStep::reset(void)
+{
+	IO_REG_TYPE mask = allMask;
+	volatile IO_REG_TYPE *reg IO_REG_ASM = baseReg;
+	IO_REG_TYPE r;
+	uint8_t retries = 125;
+
+	noInterrupts();
+	DIRECT_MODE_INPUT(reg, mask);
+	interrupts();
+	// wait until the wires are high... just in case
+	while (DIRECT_READ_MASK(reg, mask) != mask) {
+		if (--retries == 0) {
+			mask = DIRECT_READ_MASK(reg, mask); // leave out pins that are shorted
+			if (!mask) return 0;
+			break;
+		}
+		delayMicroseconds(2);
+	}
+
+	noInterrupts();
+	DIRECT_WRITE_LOW(reg, mask);
+	DIRECT_MODE_OUTPUT(reg, mask);	// drive outputs low
+	interrupts();
+	delayMicroseconds(500);
+	noInterrupts();
+	DIRECT_MODE_INPUT(reg, mask);	// allow them to float
+	delayMicroseconds(80);
+	r = ~DIRECT_READ_MASK(reg, mask) & mask;
+	interrupts();
+	delayMicroseconds(420);
+
+	uint8_t presence = 0;
+	for (uint8_t i = 0; i < numPins; i++) {
+		if (r & masks[i]) presence |= 1 << i;
+	}
+	return presence;
+}
+
+void OneWireLockStep::write(const uint8_t *data)
+{
+	IO_REG_TYPE mask = allMask;
+	volatile IO_REG_TYPE *reg IO_REG_ASM = baseReg;
+
+	for (uint8_t bitMask = 0x01; bitMask; bitMask <<= 1) {
+		// pins that write a 1 are released after the short low pulse, the others after the long one
+		IO_REG_TYPE ones = 0;
+		for (uint8_t i = 0; i < numPins; i++) {
+			if (data[i] & bitMask) ones |= masks[i];
+		}
+		noInterrupts();
+		DIRECT_WRITE_LOW(reg, mask);
+		DIRECT_MODE_OUTPUT(reg, mask);	// drive outputs low
+		delayMicroseconds(10);
+		DIRECT_WRITE_HIGH(reg, ones);	// drive outputs high
+		if (ones == mask) {
+			interrupts();
+			delayMicroseconds(55);
+		} else {
+			delayMicroseconds(55);
+			DIRECT_WRITE_HIGH(reg, mask);	// drive outputs high
+			interrupts();
+			delayMicroseconds(5);
+		}
+	}
+	noInterrupts();
+	DIRECT_MODE_INPUT(reg, mask);
+	DIRECT_WRITE_LOW(reg, mask);
+	interrupts();
+}
+
+void OneWireLockStep::read(uint8_t *data)
+{
+	IO_REG_TYPE mask = allMask;
+	volatile IO_REG_TYPE *reg IO_REG_ASM = baseReg;
+
+	for (uint8_t i = 0; i < numPins; i++) {
+		data[i] = 0;
+	}
+	for (uint8_t bitMask = 0x01; bitMask; bitMask <<= 1) {
+		IO_REG_TYPE r;
+		noInterrupts();
+		DIRECT_MODE_OUTPUT(reg, mask);
+		DIRECT_WRITE_LOW(reg, mask);
+		delayMicroseconds(3);
+		DIRECT_MODE_INPUT(reg, mask);	// let pins float, pull ups will raise
+		delayMicroseconds(10);
+		r = DIRECT_READ_MASK(reg, mask);
+		interrupts();
+		for (uint8_t i = 0; i < numPins; i++) {
+			if (r & masks[i]) data[i] |= bitMask;
+		}
+		delayMicroseconds(50);
+	}
+}
+
+#if ONEWIRE_TIMER
+//
+// Timer driven implementation. Timer1 runs in CTC mode with 0.5us ticks and its
+// compare match interrupt steps through the time slots of a transaction. Only the
+// parts of a slot that need accurate timing (the short low pulse of a write 1 and
+// the low pulse and sample of a read) are done with a busy wait inside the interrupt.
+// The long low pulse of a write 0, the reset pulse and the recovery time of each slot
+// are left to the timer, so interrupts are not masked for more than about 13us.
+//
+
+enum oneWireEngineStates{
+	OW_IDLE,
+	OW_RESET_RELEASE,
+	OW_RESET_SAMPLE,
+	OW_WRITE_ZERO_RELEASE,
+	OW_SLOT_END
+};
+
+// The variables that the interrupt changes and the main loop reads afterwards are volatile.
+// The others are only written with the timer stopped or interrupts disabled.
+static volatile uint8_t owState = OW_IDLE;
+static volatile IO_REG_TYPE *owReg;
+static IO_REG_TYPE owMask;
+static const uint8_t *owWritePtr;
+static uint8_t owWriteCount;
+static uint8_t * volatile owReadPtr;
+static volatile uint8_t owReadCount;
+static volatile uint8_t owByte;
+static volatile uint8_t owBitMask;
+static bool owReading;
+static volatile uint8_t owPresence;
+
+// next compare match after 'us' microseconds
+static inline void owSchedule(uint16_t us){
+	TCNT1 = 0;
+	OCR1A = us*2;
+}
+
+static inline void owStopTimer(void){
+	TCCR1B = 0;
+	TIMSK1 &= ~(1<<OCIE1A);
+}
+
+// Start the next time slot, or finish the transaction when all bytes are done.
+// Called from the interrupt, or with interrupts disabled.
+static void owStartNextSlot(void){
+	if(owBitMask == 0){
+		// byte complete
+		if(owReading){
+			*owReadPtr++ = owByte;
+			owReadCount--;
+		}
+		if(owWriteCount){
+			owByte = *owWritePtr++;
+			owWriteCount--;
+			owReading = false;
+			owBitMask = 0x01;
+		}
+		else if(owReadCount){
+			owByte = 0;
+			owReading = true;
+			owBitMask = 0x01;
+		}
+		else{
+			owStopTimer();
+			owState = OW_IDLE;
+			return;
+		}
+	}
+
+	DIRECT_WRITE_LOW(owReg, owMask);
+	DIRECT_MODE_OUTPUT(owReg, owMask);	// drive output low
+	if(owReading){
+		delayMicroseconds(3);
+		DIRECT_MODE_INPUT(owReg, owMask);	// let pin float, pull up will raise
+		delayMicroseconds(10);
+		if(DIRECT_READ(owReg, owMask)){
+			owByte |= owBitMask;
+		}
+		owBitMask <<= 1;
+		owSchedule(53);
+		owState = OW_SLOT_END;
+	}
+	else if(owByte & owBitMask){
+		delayMicroseconds(10);
+		DIRECT_WRITE_HIGH(owReg, owMask);	// drive output high
+		owBitMask <<= 1;
+		owSchedule(55);
+		owState = OW_SLOT_END;
+	}
+	else{
+		owSchedule(65);
+		owState = OW_WRITE_ZERO_RELEASE;
+	}
+}
+
+ISR(TIMER1_COMPA_vect){
+	switch(owState){
+		case OW_RESET_RELEASE:
+			DIRECT_MODE_INPUT(owReg, owMask);	// allow it to float
+			owSchedule(80);
+			owState = OW_RESET_SAMPLE;
+			break;
+		case OW_RESET_SAMPLE:
+			owPresence = !DIRECT_READ(owReg, owMask);
+			owSchedule(420);
+			owState = OW_SLOT_END;
+			break;
+		case OW_WRITE_ZERO_RELEASE:
+			DIRECT_WRITE_HIGH(owReg, owMask);	// drive output high
+			owBitMask <<= 1;
+			owSchedule(5);
+			owState = OW_SLOT_END;
+			break;
+		case OW_SLOT_END:
+			owStartNextSlot();
+			break;
+		default:
+			owStopTimer();
+			owState = OW_IDLE;
+			break;
+	}
+}
+
+OneWireTimerTransport::OneWireTimerTransport(uint8_t pin)
+{
+	pinMode(pin, INPUT);
+	bitmask = PIN_TO_BITMASK(pin);
+	baseReg = PIN_TO_BASEREG(pin);
+}
+
+bool OneWireTimerTransport::startTransaction(bool doReset, const uint8_t *writeBuf, uint8_t writeCount, uint8_t *readBuf, uint8_t readCount)
+{
+	if(owState != OW_IDLE){
+		return false;
+	}
+	if(doReset){
+		// wait until the wire is high... just in case
+		uint8_t retries = 125;
+		noInterrupts();
+		DIRECT_MODE_INPUT(baseReg, bitmask);
+		interrupts();
+		do {
+			if (--retries == 0){
+				owPresence = 0;
+				return false;
+			}
+			delayMicroseconds(2);
+		} while ( !DIRECT_READ(baseReg, bitmask));
+	}
+
+	noInterrupts();
+	owReg = baseReg;
+	owMask = bitmask;
+	owWritePtr = writeBuf;
+	owWriteCount = writeCount;
+	owReadPtr = readBuf;
+	owReadCount = readCount;
+	owReading = false;
+	owBitMask = 0;
+	owPresence = 0;
+
+	TCCR1A = 0;
+	TCCR1B = (1<<WGM12) | (1<<CS11); // CTC mode, prescaler 8: 0.5us per tick
+	if(doReset){
+		DIRECT_WRITE_LOW(owReg, owMask);
+		DIRECT_MODE_OUTPUT(owReg, owMask);	// drive output low
+		owSchedule(500);
+		owState = OW_RESET_RELEASE;
+	}
+	else{
+		owStartNextSlot();
+	}
+	if(owState != OW_IDLE){
+		TIFR1 = (1<<OCF1A); // clear pending compare match
+		TIMSK1 |= (1<<OCIE1A);
+	}
+	interrupts();
+	return true;
+}
+
+bool OneWireTimerTransport::transactionBusy(void)
+{
+	if(owState != OW_IDLE){
+		return true;
+	}
+	__asm__ __volatile__ ("" ::: "memory"); // read buffer is complete, see owWait()
+	return false;
+}
+
+uint8_t OneWireTimerTransport::transactionPresence(void)
+{
+	return owPresence;
+}
+
+// The blocking functions below start a transaction and wait for the timer to finish it.
+// Interrupts are enabled while waiting, so other interrupts are serviced on time.
+static inline void owWait(void){
+	while(owState != OW_IDLE){
+		;
+	}
+	// the interrupt has written the read buffer, don't let the compiler read it before this point
+	__asm__ __volatile__ ("" ::: "memory");
+}
+
+uint8_t OneWireTimerTransport::reset(void)
+{
+	owWait();
+	if(!startTransaction(true, 0, 0, 0, 0)){
+		return 0; // bus is shorted
+	}
+	owWait();
+	return owPresence;
+}
+
+void OneWireTimerTransport::write_bit(uint8_t v)
+{
+	owWait();
+	uint8_t b = (v & 1) ? 0x80 : 0;
+	noInterrupts();
+	owReg = baseReg;
+	owMask = bitmask;
+	owWriteCount = 0;
+	owReadCount = 0;
+	owReading = false;
+	owByte = b;
+	owBitMask = 0x80; // single slot: byte is complete after this bit
+	TCCR1A = 0;
+	TCCR1B = (1<<WGM12) | (1<<CS11);
+	owStartNextSlot();
+	TIFR1 = (1<<OCF1A);
+	TIMSK1 |= (1<<OCIE1A);
+	interrupts();
+	owWait();
+}
+
+uint8_t OneWireTimerTransport::read_bit(void)
+{
+	uint8_t r;
+	owWait();
+	noInterrupts();
+	owReg = baseReg;
+	owMask = bitmask;
+	owWriteCount = 0;
+	owReadPtr = &r;
+	owReadCount = 1;
+	owReading = true;
+	owByte = 0;
+	owBitMask = 0x80; // single slot: byte is complete after this bit
+	TCCR1A = 0;
+	TCCR1B = (1<<WGM12) | (1<<CS11);
+	owStartNextSlot();
+	TIFR1 = (1<<OCF1A);
+	TIMSK1 |= (1<<OCIE1A);
+	interrupts();
+	owWait();
+	return r ? 1 : 0;
+}
+
+void OneWireTimerTransport::write_bytes(const uint8_t *buf, uint16_t count)
+{
+	while(count){
+		uint8_t n = (count > 255) ? 255 : count;
+		owWait();
+		startTransaction(false, buf, n, 0, 0);
+		buf += n;
+		count -= n;
+	}
+	owWait();
+}
+
+void OneWireTimerTransport::read_bytes(uint8_t *buf, uint16_t count)
+{
+	while(count){
+		uint8_t n = (count > 255) ? 255 : count;
+		owWait();
+		startTransaction(false, 0, 0, buf, n);
+		buf += n;
+		count -= n;
+	}
+	owWait();
+}
+
+void OneWireTimerTransport::release(void)
+{
+	owWait();
+	noInterrupts();
+	DIRECT_MODE_INPUT(baseReg, bitmask);
+	DIRECT_WRITE_LOW(baseReg, bitmask);
+	interrupts();
+}
+
+void OneWireTimerTransport::depower(void)
+{
+	owWait();
+	noInterrupts();
+	DIRECT_MODE_INPUT(baseReg, bitmask);
+	interrupts();
+}
+
+#endif // ONEWIRE_TIMER
+
+#endif // !ONEWIRE_SIMULATION
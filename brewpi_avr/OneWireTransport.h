@@ -0,0 +1,169 @@
+/*
+The bit level transports used by OneWire. The pin and timer transports were
+split out of OneWire.cpp, see there for the copyright and license.
+*/
+
+#ifndef OneWireTransport_h
+#define OneWireTransport_h
+
+#include <inttypes.h>
+
+#if ARDUINO >= 100
+#include "Arduino.h"       // for delayMicroseconds, digitalPinToBitMask, etc
+#else
+#include "WProgram.h"      // for delayMicroseconds
+#include "pins_arduino.h"  // for digitalPinToBitMask, etc
+#endif
+
+// A transport puts the bits on the wire for OneWire. Each transport implements:
+//
+//    Transport(uint8_t pin);
+//    uint8_t reset(void);            // reset pulse, returns 1 on a presence pulse
+//    void write_bit(uint8_t v);      // write slot, bus is left powered
+//    uint8_t read_bit(void);         // read slot
+//    void write_bytes(const uint8_t *buf, uint16_t count);   // LSB first, bus is left powered
+//    void read_bytes(uint8_t *buf, uint16_t count);          // LSB first
+//    void release(void);             // tri-state the pin without pull-up
+//    void depower(void);             // stop driving the pin
+//
+// The transport is picked at compile time, so OneWire calls it without the
+// overhead of virtual functions:
+//    OneWirePinTransport    bit-banged, AVR and PIC32 (default)
+//    OneWireTimerTransport  Timer1 interrupt driven, AVR (ONEWIRE_TIMER)
+//    OneWireSimTransport    simulated devices, any other platform (see OneWireSim.h)
+//
+// OneWireLockStep runs the same transaction on several pins at once, with
+// different data on each pin.
+
+// Maximum number of pins in a OneWireLockStep
+#define ONEWIRE_MAX_LOCKSTEP_PINS 4
+
+// Platform specific I/O definitions
+
+#if defined(__AVR__)
+#define PIN_TO_BASEREG(pin)             (portInputRegister(digitalPinToPort(pin)))
+#define PIN_TO_BITMASK(pin)             (digitalPinToBitMask(pin))
+#define IO_REG_TYPE uint8_t
+#define IO_REG_ASM asm("r30")
+#define DIRECT_READ(base, mask)         (((*(base)) & (mask)) ? 1 : 0)
+#define DIRECT_READ_MASK(base, mask)    ((*(base)) & (mask))
+#define DIRECT_MODE_INPUT(base, mask)   ((*(base+1)) &= ~(mask))
+#define DIRECT_MODE_OUTPUT(base, mask)  ((*(base+1)) |= (mask))
+#define DIRECT_WRITE_LOW(base, mask)    ((*(base+2)) &= ~(mask))
+#define DIRECT_WRITE_HIGH(base, mask)   ((*(base+2)) |= (mask))
+
+#elif defined(__PIC32MX__)
+#include <plib.h>  // is this necessary?
+#define PIN_TO_BASEREG(pin)             (portModeRegister(digitalPinToPort(pin)))
+#define PIN_TO_BITMASK(pin)             (digitalPinToBitMask(pin))
+#define IO_REG_TYPE uint32_t
+#define IO_REG_ASM
+#define DIRECT_READ(base, mask)         (((*(base+4)) & (mask)) ? 1 : 0)  //PORTX + 0x10
+#define DIRECT_READ_MASK(base, mask)    ((*(base+4)) & (mask))
+#define DIRECT_MODE_INPUT(base, mask)   ((*(base+2)) = (mask))            //TRISXSET + 0x08
+#define DIRECT_MODE_OUTPUT(base, mask)  ((*(base+1)) = (mask))            //TRISXCLR + 0x04
+#define DIRECT_WRITE_LOW(base, mask)    ((*(base+8+1)) = (mask))          //LATXCLR  + 0x24
+#define DIRECT_WRITE_HIGH(base, mask)   ((*(base+8+2)) = (mask))          //LATXSET + 0x28
+
+#else
+// No pins to drive: the bus is simulated
+#ifndef ONEWIRE_SIMULATION
+#define ONEWIRE_SIMULATION 1
+#endif
+#endif
+
+#ifndef ONEWIRE_SIMULATION
+#define ONEWIRE_SIMULATION 0
+#endif
+
+#if !ONEWIRE_SIMULATION
+
+// Bit-banged transport. Interrupts are disabled during the timing critical
+// parts of each slot.
+class OneWirePinTransport
+{
+  private:
+    IO_REG_TYPE bitmask;
+    volatile IO_REG_TYPE *baseReg;
+
+  public:
+    OneWirePinTransport(uint8_t pin);
+    uint8_t reset(void);
+    void write_bit(uint8_t v);
+    uint8_t read_bit(void);
+    void write_bytes(const uint8_t *buf, uint16_t count);
+    void read_bytes(uint8_t *buf, uint16_t count);
+    void release(void);
+    void depower(void);
+};
+
+// Bit-banged slots on several pins of the same port at once. All pins are driven and
+// sampled with the same register access, so the time of a slot is shared by all pins.
+// Bytes are passed as arrays with one byte for each pin, in the order the pins were added.
+class OneWireLockStep
+{
+  private:
+    IO_REG_TYPE masks[ONEWIRE_MAX_LOCKSTEP_PINS];
+    IO_REG_TYPE allMask;
+    volatile IO_REG_TYPE *baseReg;
+    uint8_t numPins;
+
+  public:
+    OneWireLockStep(void);
+
+    // Returns false if the pin is not on the same port as the other pins, was already
+    // added or there is no room for another pin.
+    bool addPin(uint8_t pin);
+
+    uint8_t getNumPins(void){
+      return numPins;
+    }
+
+    // Reset all pins. Returns a bit mask with bit i set when pin i has a presence pulse.
+    uint8_t reset(void);
+
+    // Write data[i] to pin i. The pins are released at the end.
+    void write(const uint8_t *data);
+
+    // Read a byte from pin i into data[i]
+    void read(uint8_t *data);
+};
+
+#if ONEWIRE_TIMER
+// Timer1 interrupt driven transport. There is only one timer, so one transaction
+// can run at a time on all OneWire objects.
+class OneWireTimerTransport
+{
+  private:
+    IO_REG_TYPE bitmask;
+    volatile IO_REG_TYPE *baseReg;
+
+  public:
+    OneWireTimerTransport(uint8_t pin);
+    uint8_t reset(void);
+    void write_bit(uint8_t v);
+    uint8_t read_bit(void);
+    void write_bytes(const uint8_t *buf, uint16_t count);
+    void read_bytes(uint8_t *buf, uint16_t count);
+    void release(void);
+    void depower(void);
+
+    bool startTransaction(bool doReset, const uint8_t *writeBuf, uint8_t writeCount, uint8_t *readBuf, uint8_t readCount);
+    static bool transactionBusy(void);
+    static uint8_t transactionPresence(void);
+};
+
+typedef OneWireTimerTransport OneWireTransport;
+#else
+typedef OneWirePinTransport OneWireTransport;
+#endif
+
+#else
+
+#include "OneWireSim.h"
+
+typedef OneWireSimTransport OneWireTransport;
+
+#endif // !ONEWIRE_SIMULATION
+
+#endif
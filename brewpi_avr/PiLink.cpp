@@ -86,6 +86,9 @@ void PiLink::receive(void){
 		case 'v': // Control variables requested
 			sendControlVariables();
 			break;
+		case 'h': // Temperature sensor health requested
+			sendSensorHealth();
+			break;
 		case 'n':
 			print_P(PSTR("N:%S\n"), PSTR(VERSION_STRING));
 			break;
@@ -227,6 +230,13 @@ void PiLink::sendControlConstants(void){
 	sendJsonPair(JSONKEY_beerFastFilter, tempControl.cc.beerFastFilter);
 	sendJsonPair(JSONKEY_beerSlowFilter, tempControl.cc.beerSlowFilter);
 	sendJsonPair(JSONKEY_beerSlopeFilter, tempControl.cc.beerSlopeFilter);
+	sendJsonPair(JSONKEY_fridgeFastSections, tempControl.cc.fridgeFastSections);
+	sendJsonPair(JSONKEY_fridgeSlowSections, tempControl.cc.fridgeSlowSections);
+	sendJsonPair(JSONKEY_fridgeSlopeSections, tempControl.cc.fridgeSlopeSections);
+	sendJsonPair(JSONKEY_beerFastSections, tempControl.cc.beerFastSections);
+	sendJsonPair(JSONKEY_beerSlowSections, tempControl.cc.beerSlowSections);
+	sendJsonPair(JSONKEY_beerSlopeSections, tempControl.cc.beerSlopeSections);
+	sendJsonPair(JSONKEY_pidInput, tempControl.cc.pidInput);
 	sendJsonClose();
 }
 
@@ -245,6 +255,36 @@ void PiLink::sendControlVariables(void){
 	sendJsonPair(JSONKEY_posPeakEstimate, tempToString(tempString, tempControl.cv.posPeakEstimate, 3, 12));
 	sendJsonPair(JSONKEY_negPeak, tempToString(tempString, tempControl.cv.negPeak, 3, 12));
 	sendJsonPair(JSONKEY_posPeak, tempToString(tempString, tempControl.cv.posPeak, 3, 12));
+#if TEMP_CONTROL_KALMAN
+	sendJsonPair(JSONKEY_kalmanTemp, tempToString(tempString, tempControl.beerEstimator.readTemperature(), 3, 12));
+	sendJsonPair(JSONKEY_kalmanSlope, tempDiffToString(tempString, tempControl.beerEstimator.readSlope(), 3, 12));
+#endif
+	sendJsonPair(JSONKEY_beerPollTime, tempControl.beerSensor.getMaxPollTime());
+	sendJsonPair(JSONKEY_fridgePollTime, tempControl.fridgeSensor.getMaxPollTime());
+	sendJsonClose();
+}
+
+void PiLink::sendSensorHealth(void){
+	sendSensorHealth(tempControl.beerSensor);
+	sendSensorHealth(tempControl.fridgeSensor);
+}
+
+void PiLink::sendSensorHealth(TempSensor & sensor){
+	const TempSensorStats & stats = sensor.getStats();
+	printResponse('H');
+	sendJsonPair(JSONKEY_sensorRole, sensor.getRole());
+	sendJsonPair(JSONKEY_sensorPin, sensor.getPin());
+	sendJsonPair(JSONKEY_sensorConnected, (uint8_t) sensor.isConnected());
+	sendJsonPair(JSONKEY_sensorResolution, sensor.getResolution());
+	sendJsonPair(JSONKEY_fastReads, stats.fastReads);
+	sendJsonPair(JSONKEY_fullReads, stats.fullReads);
+	sendJsonPair(JSONKEY_rejectedReads, stats.rejectedReads);
+	sendJsonPair(JSONKEY_crcErrors, stats.crcErrors);
+	sendJsonPair(JSONKEY_presenceErrors, stats.presenceErrors);
+	sendJsonPair(JSONKEY_disconnects, stats.disconnects);
+	sendJsonPair(JSONKEY_reconnects, stats.reconnects);
+	sendJsonPair(JSONKEY_maxReadTime, stats.maxReadTime);
+	sendJsonPair(JSONKEY_meanReadTime, sensor.getMeanReadTime());
 	sendJsonClose();
 }
 
@@ -345,6 +385,26 @@ void PiLink::receiveJson(void){
 	}
 }
 
+// number of filter sections, limited to the range the filters support
+static uint8_t stringToSections(const char * val){
+	unsigned long count = strtoul(val, NULL, 10);
+	if(count < 1){
+		return 1;
+	}
+	if(count > CASCADED_FILTER_MAX_SECTIONS){
+		return CASCADED_FILTER_MAX_SECTIONS;
+	}
+	return count;
+}
+
+static uint8_t stringToPidInput(const char * val){
+	unsigned long pidInput = strtoul(val, NULL, 10);
+	if(pidInput > PID_INPUT_KALMAN){
+		return PID_INPUT_KALMAN;
+	}
+	return pidInput;
+}
+
 void PiLink::processJsonPair(char * key, char * val){
 	debugMessage(PSTR("Received new setting: %s = %s"), key, val);
 	if(strcmp_P(key,JSONKEY_mode) == 0){
@@ -418,6 +478,33 @@ void PiLink::processJsonPair(char * key, char * val){
 		tempControl.cc.beerSlopeFilter = strtoul(val, NULL, 10);
 		tempControl.beerSensor.setSlopeFilterCoefficients(tempControl.cc.beerSlopeFilter);
 	}
+	
+	// Receive the number of sections of the filter
+	else if(strcmp_P(key,JSONKEY_fridgeFastSections) == 0){
+		tempControl.cc.fridgeFastSections = stringToSections(val);
+		tempControl.fridgeSensor.setFastFilterSections(tempControl.cc.fridgeFastSections);
+	}
+	else if(strcmp_P(key,JSONKEY_fridgeSlowSections) == 0){
+		tempControl.cc.fridgeSlowSections = stringToSections(val);
+		tempControl.fridgeSensor.setSlowFilterSections(tempControl.cc.fridgeSlowSections);
+	}
+	else if(strcmp_P(key,JSONKEY_fridgeSlopeSections) == 0){
+		tempControl.cc.fridgeSlopeSections = stringToSections(val);
+		tempControl.fridgeSensor.setSlopeFilterSections(tempControl.cc.fridgeSlopeSections);
+	}
+	else if(strcmp_P(key,JSONKEY_beerFastSections) == 0){
+		tempControl.cc.beerFastSections = stringToSections(val);
+		tempControl.beerSensor.setFastFilterSections(tempControl.cc.beerFastSections);
+	}
+	else if(strcmp_P(key,JSONKEY_beerSlowSections) == 0){
+		tempControl.cc.beerSlowSections = stringToSections(val);
+		tempControl.beerSensor.setSlowFilterSections(tempControl.cc.beerSlowSections);
+	}
+	else if(strcmp_P(key,JSONKEY_beerSlopeSections) == 0){
+		tempControl.cc.beerSlopeSections = stringToSections(val);
+		tempControl.beerSensor.setSlopeFilterSections(tempControl.cc.beerSlopeSections);
+	}
+	else if(strcmp_P(key,JSONKEY_pidInput) == 0){ tempControl.cc.pidInput = stringToPidInput(val); }
 	else{
 		debugMessage(PSTR("Could not process setting"));
 	}
@@ -22,6 +22,8 @@
 
 #include "temperatureFormats.h"
 
+class TempSensor;
+
 class PiLink{
 	public:
 	
@@ -41,6 +43,7 @@ class PiLink{
 	static void receiveControlConstants(void);
 	static void sendControlConstants(void);
 	static void sendControlVariables(void);
+	static void sendSensorHealth(void); // send the health counters of each temperature sensor
 	
 	static void receiveJson(void); // receive settings as JSON key:value pairs
 	
@@ -49,6 +52,7 @@ class PiLink{
 	static void printResponse(char type);
 	
 	static void printTemperaturesJSON(char * beerAnnotation, char * fridgeAnnotation);
+	static void sendSensorHealth(TempSensor & sensor);
 	static void sendJsonPair(const char * name, const char * val); // send one JSON pair with a string value as name:val,
 	static void sendJsonPair(const char * name, char val); // send one JSON pair with a char value as name:val,
 	static void sendJsonPair(const char * name, uint16_t val); // send one JSON pair with a uint16_t value as name:val,
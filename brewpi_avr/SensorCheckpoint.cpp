@@ -0,0 +1,111 @@
+/*
+ * Copyright 2012 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ * 
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "SensorCheckpoint.h"
+
+#include <avr/eeprom.h>
+#include <avr/io.h>
+#include <stddef.h>
+#include <string.h>
+#include "OneWire.h"
+#include "TempControl.h"
+
+#if TEMP_SENSOR_CHECKPOINT
+
+SensorCheckpoint sensorCheckpoint;
+
+uint16_t SensorCheckpoint::countdown = TEMP_SENSOR_CHECKPOINT_INTERVAL;
+uint8_t SensorCheckpoint::nextSlot = 0;
+SensorCheckpointSlot SensorCheckpoint::lastStored;
+
+#if defined(__AVR__)
+// Runs before the C runtime clears the variables (in .init4), so resetFlags is in .noinit.
+// MCUSR is cleared, otherwise the flags of earlier resets add up.
+static uint8_t resetFlags __attribute__ ((section (".noinit")));
+static void saveResetFlags(void) __attribute__ ((naked, used, section (".init3")));
+static void saveResetFlags(void){
+	resetFlags = MCUSR;
+	MCUSR = 0;
+}
+#else
+#define resetFlags MCUSR // set by the host tests
+#endif
+
+uint8_t SensorCheckpoint::crc(const SensorCheckpointSlot & slot){
+	return OneWire::crc8((uint8_t *) &slot, offsetof(SensorCheckpointSlot, crc));
+}
+
+bool SensorCheckpoint::restore(void){
+	SensorCheckpointSlot slot;
+	int8_t newest = -1;
+	for(uint8_t i=0; i<SENSOR_CHECKPOINT_SLOTS; i++){
+		eeprom_read_block((void *) &slot, (void *) (EEPROM_CHECKPOINT_ADDRESS + i*sizeof(SensorCheckpointSlot)), sizeof(SensorCheckpointSlot));
+		if(slot.format != EEPROM_FORMAT_VERSION || slot.crc != crc(slot)){
+			continue; // never written, written partially or by another firmware version
+		}
+		// the sequence wraps around, compare the difference
+		if(newest < 0 || (int8_t) (slot.sequence - lastStored.sequence) > 0){
+			newest = i;
+			lastStored = slot;
+		}
+	}
+	if(newest < 0){
+		lastStored.sequence = 0;
+		return false;
+	}
+	// continue the rotation, also when the checkpoint is not used
+	nextSlot = (newest + 1) % SENSOR_CHECKPOINT_SLOTS;
+	if(!(resetFlags & (_BV(WDRF) | _BV(EXTRF))) || (resetFlags & (_BV(PORF) | _BV(BORF)))){
+		return false; // the power was off for an unknown time
+	}
+	tempControl.beerSensor.setRestorePoint(lastStored.beer);
+	tempControl.fridgeSensor.setRestorePoint(lastStored.fridge);
+	return true;
+}
+
+void SensorCheckpoint::update(void){
+	if(--countdown != 0){
+		return;
+	}
+	countdown = TEMP_SENSOR_CHECKPOINT_INTERVAL;
+	store();
+}
+
+void SensorCheckpoint::store(void){
+	SensorCheckpointSlot slot;
+	tempControl.beerSensor.getCheckpoint(slot.beer);
+	tempControl.fridgeSensor.getCheckpoint(slot.fridge);
+	if(slot.beer.temperature == INT_MIN && slot.fridge.temperature == INT_MIN){
+		return; // nothing to store
+	}
+	if(memcmp(&slot.beer, &lastStored.beer, sizeof(TempSensorCheckpoint)) == 0
+		&& memcmp(&slot.fridge, &lastStored.fridge, sizeof(TempSensorCheckpoint)) == 0){
+		return; // the last checkpoint is still valid
+	}
+	slot.format = EEPROM_FORMAT_VERSION;
+	slot.sequence = lastStored.sequence + 1;
+	slot.crc = crc(slot);
+	// Only bytes that have changed are written
+	eeprom_update_block((void *) &slot, (void *) (EEPROM_CHECKPOINT_ADDRESS + nextSlot*sizeof(SensorCheckpointSlot)), sizeof(SensorCheckpointSlot));
+	lastStored = slot;
+	nextSlot = (nextSlot + 1) % SENSOR_CHECKPOINT_SLOTS;
+}
+
+#endif
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2012 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ * 
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SENSORCHECKPOINT_H_
+#define SENSORCHECKPOINT_H_
+
+#include <inttypes.h>
+#include "TempSensor.h"
+
+// Number of checkpoints in EEPROM. They are written in turn, so each byte is written once every
+// TEMP_SENSOR_CHECKPOINT_INTERVAL * SENSOR_CHECKPOINT_SLOTS seconds.
+#define SENSOR_CHECKPOINT_SLOTS 4
+
+// One checkpoint in EEPROM, stored after the device table
+struct SensorCheckpointSlot{
+	uint8_t format; // EEPROM_FORMAT_VERSION when the slot was written. A zeroed or older slot does not match.
+	uint8_t sequence; // incremented for each write, the slot with the highest sequence is the most recent
+	TempSensorCheckpoint beer;
+	TempSensorCheckpoint fridge;
+	uint8_t crc; // OneWire::crc8 of the members above
+};
+
+/* The sensor checkpoint stores the filter state of the beer and fridge sensor in EEPROM, so the filters can
+ * continue after a reset (for example by the watchdog), instead of starting from one reading with a slope of 0.
+ * The Arduino has no clock that survives a reset, so the age of a checkpoint is not known. A checkpoint is only
+ * used when the first reading agrees with it, see TEMP_SENSOR_CHECKPOINT_TOLERANCE.
+ * Checkpoints are only used after a reset by the watchdog or the reset pin (the serial port resets the Arduino when
+ * it is opened). After a power-on or brown-out reset, the power was lost for an unknown time and the filters start
+ * from the first reading. The reset flags are copied from MCUSR before main(). A bootloader that clears MCUSR
+ * hides the reset cause, then no checkpoint is used.
+ * To spare the EEPROM, a checkpoint is written at most every TEMP_SENSOR_CHECKPOINT_INTERVAL seconds, only when it
+ * has changed, and the writes rotate over SENSOR_CHECKPOINT_SLOTS slots. With the defaults, each byte is written
+ * at most once every 40 minutes, about 13000 times a year.
+ */
+class SensorCheckpoint{
+	public:
+	SensorCheckpoint(){};
+	~SensorCheckpoint(){};
+	
+	// Pass the most recent valid checkpoint to the sensors. Call once at startup.
+	// Returns true when a checkpoint was passed on.
+	static bool restore(void);
+	static void update(void); // call once per second
+	
+	private:
+	static uint8_t crc(const SensorCheckpointSlot & slot);
+	static void store(void);
+	
+	static uint16_t countdown; // seconds until the next write
+	static uint8_t nextSlot;
+	static SensorCheckpointSlot lastStored;
+};
+
+extern SensorCheckpoint sensorCheckpoint;
+
+#endif /* SENSORCHECKPOINT_H_ */
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2012 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ * 
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "SlopeEstimator.h"
+
+static const uint8_t N = SLOPE_ESTIMATOR_POINTS;
+// Least squares slope per point of points y(i), i = 0..N-1: (12 * sum(i*y) - 6*(N-1) * sum(y)) / (N*(N^2-1))
+#define SLOPE_DENOMINATOR ((long) N * (N * N - 1) * SLOPE_ESTIMATOR_INTERVAL) // per sample instead of per point
+
+SlopeEstimator::SlopeEstimator(){
+	init(0);
+}
+
+void SlopeEstimator::init(fixed7_9 val, fixed7_9 slopePerHour){
+	sum = 0;
+	weightedSum = 0;
+	for(uint8_t i=0; i<N; i++){
+		// the newest point is at N-1
+		points[i] = val - ((int32_t) slopePerHour * ((N - 1 - i) * SLOPE_ESTIMATOR_INTERVAL)) / 3600;
+		sum += points[i];
+		weightedSum += (int32_t) points[i] * i;
+	}
+	intervalSum = 0;
+	intervalCount = 0;
+	index = 0;
+	slope = slopePerHour;
+}
+
+void SlopeEstimator::add(fixed7_9 val){
+	intervalSum += val;
+	if(++intervalCount < SLOPE_ESTIMATOR_INTERVAL){
+		return;
+	}
+	addPoint(intervalSum / SLOPE_ESTIMATOR_INTERVAL);
+	intervalSum = 0;
+	intervalCount = 0;
+}
+
+void SlopeEstimator::addPoint(fixed7_9 point){
+	fixed7_9 oldest = points[index];
+	points[index] = point;
+	if(++index == N){
+		index = 0;
+	}
+	// All points move one position towards the oldest, the oldest point drops out and the new point is at N-1.
+	// With 100 points, weightedSum stays below 32768 * 100 * 99 / 2, so 12 * weightedSum fits in 32 bits.
+	sum -= oldest;
+	weightedSum -= sum;
+	weightedSum += (int32_t) point * (N - 1);
+	sum += point;
+	
+	int32_t numerator = 12 * weightedSum - (int32_t) (6 * (N - 1)) * sum;
+	// slope per hour is numerator * 3600 / SLOPE_DENOMINATOR. Divide first, the remainder times 3600 fits in 32 bits.
+	// A quotient of 10 or more is more than the fixed7_9 range per hour.
+	int32_t quotient = numerator / SLOPE_DENOMINATOR;
+	int32_t remainder = numerator % SLOPE_DENOMINATOR;
+	int32_t perHour = 0;
+	if(quotient > -10 && quotient < 10){
+		perHour = quotient * 3600 + (remainder * 3600) / SLOPE_DENOMINATOR;
+	}
+	if(perHour > 32767 || quotient >= 10){
+		perHour = 32767; // limit to the fixed7_9 range
+	}
+	if(perHour < -32767 || quotient <= -10){
+		perHour = -32767; // INT_MIN is used for 'no value'
+	}
+	slope = perHour;
+}
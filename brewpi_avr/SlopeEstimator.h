@@ -0,0 +1,74 @@
+/*
+ * Copyright 2012 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ * 
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SLOPEESTIMATOR_H_
+#define SLOPEESTIMATOR_H_
+
+#include "temperatureFormats.h"
+
+// The window of the estimator is SLOPE_ESTIMATOR_POINTS points. Each point is the average of
+// SLOPE_ESTIMATOR_INTERVAL samples, so the window is POINTS * INTERVAL samples long (300s by default).
+#ifndef SLOPE_ESTIMATOR_POINTS
+#define SLOPE_ESTIMATOR_POINTS 30
+#endif
+#ifndef SLOPE_ESTIMATOR_INTERVAL
+#define SLOPE_ESTIMATOR_INTERVAL 10
+#endif
+
+// The running sums are 32 bit and the slope per hour is calculated with 32 bit division, see SlopeEstimator::addPoint
+#if SLOPE_ESTIMATOR_POINTS < 2 || SLOPE_ESTIMATOR_POINTS > 100
+#error "SLOPE_ESTIMATOR_POINTS must be between 2 and 100"
+#endif
+#if SLOPE_ESTIMATOR_INTERVAL * SLOPE_ESTIMATOR_POINTS * (SLOPE_ESTIMATOR_POINTS * SLOPE_ESTIMATOR_POINTS - 1) > 596000L
+#error "The window of the slope estimator is too long"
+#endif
+
+/* SlopeEstimator fits a straight line through the last SLOPE_ESTIMATOR_POINTS points with least squares.
+ * The slope of the line is the estimate. The sum and the index weighted sum of the points are updated when a
+ * point is added, so each point takes the same time, independent of the window length.
+ * For a constant slope, the estimate has no lag. When the slope changes, the estimate follows in one window,
+ * with a delay of about half a window.
+ * The sample rate is one sample per second, the slope is in degrees per hour.
+ */
+class SlopeEstimator{
+	public:
+	SlopeEstimator();
+	~SlopeEstimator() {}
+	
+	void init(fixed7_9 val, fixed7_9 slopePerHour = 0); // fill the window with a line that ends at val
+	void add(fixed7_9 val);
+	
+	fixed7_9 readSlope(void){
+		return slope;
+	}
+	
+	private:
+	void addPoint(fixed7_9 point);
+	
+	fixed7_9 points[SLOPE_ESTIMATOR_POINTS]; // ring buffer, oldest point at index
+	int32_t sum; // sum of the points
+	int32_t weightedSum; // sum of the points multiplied by their position in the window, 0 for the oldest
+	int32_t intervalSum; // sum of the samples of the next point
+	uint8_t index;
+	uint8_t intervalCount;
+	fixed7_9 slope; // per hour
+};
+
+#endif /* SLOPEESTIMATOR_H_ */
@@ -44,7 +44,7 @@ void SpiLcd::init(uint8_t latchPin)
 	_backlightTime = 0;
 }
 
-void SpiLcd::begin(uint8_t cols, uint8_t lines) {
+void SpiLcd::begin(uint8_t /* cols */, uint8_t lines) {
 	_numlines = lines;
 	_currline = 0;
 	_currpos = 0;
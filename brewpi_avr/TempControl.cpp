@@ -28,14 +28,22 @@
 #include "TempControl.h"
 #include "PiLink.h"
 #include "TempSensor.h"
+#include "DeviceRegistry.h"
 #include "Ticks.h"
 
 
 TempControl tempControl;
 
+// One bus per sensor pin. Sensors on the same pin must share a bus.
+static TempSensorBus beerSensorBus(beerSensorPin);
+static TempSensorBus fridgeSensorBus(fridgeSensorPin);
+
 // Declare static variables
-TempSensor TempControl::beerSensor(beerSensorPin);
-TempSensor TempControl::fridgeSensor(fridgeSensorPin);
+TempSensor TempControl::beerSensor(DEVICE_ROLE_BEER, beerSensorBus);
+TempSensor TempControl::fridgeSensor(DEVICE_ROLE_FRIDGE, fridgeSensorBus);
+#if TEMP_CONTROL_KALMAN
+KalmanEstimator TempControl::beerEstimator;
+#endif
 	
 // Control parameters
 ControlConstants TempControl::cc;
@@ -69,14 +77,31 @@ void TempControl::reset(void){
 }
 
 void TempControl::updateTemperatures(void){
-	beerSensor.update();
-	if(!beerSensor.isConnected() && (cs.mode == MODE_BEER_CONSTANT || cs.mode == MODE_FRIDGE_CONSTANT)){
-		beerSensor.init(); // try to restart the sensor when controlling beer temperature
+	// Use fast, coarse conversions for the fridge sensor while the fridge temperature changes quickly:
+	// when cooling or heating and while waiting for the peak after it. The beer sensor always uses full resolution.
+	if(state == COOLING || state == HEATING || doPosPeakDetect || doNegPeakDetect){
+		fridgeSensor.setResolution(TEMP_SENSOR_RESOLUTION_FAST);
+	}
+	else{
+		fridgeSensor.setResolution(TEMP_SENSOR_RESOLUTION_FULL);
 	}
+	// disconnected sensors are found again by poll(), with a back-off between attempts
+	beerSensor.update();
 	fridgeSensor.update();
-	if(!fridgeSensor.isConnected()){
-		fridgeSensor.init(); // always try to restart the fridge sensor
+#if TEMP_CONTROL_KALMAN
+	if(beerSensor.isConnected()){
+		beerEstimator.add(beerSensor.read(), fridgeSensor.isConnected() ? fridgeSensor.readFastFiltered() : INT_MIN);
+	}
+	else{
+		beerEstimator.reset(); // start again from the first reading after a reconnect
 	}
+#endif
+}
+
+// collect sensor readings as soon as the conversion is complete. Called on every pass of the main loop.
+void TempControl::pollSensors(void){
+	TempSensor * const sensors[] = {&beerSensor, &fridgeSensor};
+	TempSensor::pollAll(sensors, 2); // sensors on the same port are read at the same time
 }
 
 void TempControl::updatePID(void){
@@ -90,8 +115,17 @@ void TempControl::updatePID(void){
 		}
 		
 		// fridge setting is calculated with PID algorithm. Beer temperature error is input to PID
-		cv.beerDiff =  cs.beerSetting - beerSensor.readSlowFiltered();
-		cv.beerSlope = beerSensor.readSlope();
+#if TEMP_CONTROL_KALMAN
+		if(cc.pidInput == PID_INPUT_KALMAN && beerEstimator.isInitialized()){
+			cv.beerDiff = cs.beerSetting - beerEstimator.readTemperature();
+			cv.beerSlope = beerEstimator.readSlope();
+		}
+		else
+#endif
+		{
+			cv.beerDiff =  cs.beerSetting - beerSensor.readSlowFiltered();
+			cv.beerSlope = beerSensor.readSlope();
+		}
 		if(integralUpdateCounter++ == 60){
 			integralUpdateCounter = 0;
 			if(abs(cv.beerDiff) < cc.iMaxError){
@@ -291,7 +325,7 @@ void TempControl::detectPeaks(void){
 			piLink.debugMessage(PSTR("Positive peak detected."));
 			detected = true;
 		}
-		else if(timeSinceHeating() + 10 > HEAT_PEAK_DETECT_TIME && fridgeSensor.readFastFiltered() < (cv.posPeakEstimate+cc.heatingTargetLower)){
+		else if(timeSinceHeating() + 10u > HEAT_PEAK_DETECT_TIME && fridgeSensor.readFastFiltered() < (cv.posPeakEstimate+cc.heatingTargetLower)){
 			// Idle period almost reaches maximum allowed time for peak detection
 			// This is the heat, then drift up too slow (but in the right direction).
 			// estimator is too high
@@ -332,7 +366,7 @@ void TempControl::detectPeaks(void){
 			piLink.debugMessage(PSTR("Negative peak detected."));
 			detected = true;
 		}
-		else if(timeSinceCooling() + 10 > COOL_PEAK_DETECT_TIME && fridgeSensor.readFastFiltered() > (cv.negPeakEstimate+cc.coolingTargetUpper)){
+		else if(timeSinceCooling() + 10u > COOL_PEAK_DETECT_TIME && fridgeSensor.readFastFiltered() > (cv.negPeakEstimate+cc.coolingTargetUpper)){
 			// Idle period almost reaches maximum allowed time for peak detection
 			// This is the cooling, then drift down too slow (but in the right direction).
 			// estimator is too high
@@ -393,12 +427,6 @@ void TempControl::storeSettings(void){
 
 void TempControl::loadSettings(void){
 	eeprom_read_block((void *) &cs, (void *) EEPROM_CONTROL_SETTINGS_ADDRESS, sizeof(ControlSettings));
-	fridgeSensor.setFastFilterCoefficients(cc.fridgeFastFilter);
-	fridgeSensor.setSlowFilterCoefficients(cc.fridgeSlowFilter);
-	fridgeSensor.setSlopeFilterCoefficients(cc.fridgeSlopeFilter);
-	beerSensor.setFastFilterCoefficients(cc.beerFastFilter);
-	beerSensor.setSlowFilterCoefficients(cc.beerSlowFilter);
-	beerSensor.setSlopeFilterCoefficients(cc.beerSlopeFilter);
 }
 
 void TempControl::loadDefaultSettings(void){
@@ -416,6 +444,18 @@ void TempControl::storeConstants(void){
 
 void TempControl::loadConstants(void){
 	eeprom_read_block((void *) &cc, (void *) EEPROM_CONTROL_CONSTANTS_ADDRESS, sizeof(ControlConstants));
+	fridgeSensor.setFastFilterCoefficients(cc.fridgeFastFilter);
+	fridgeSensor.setSlowFilterCoefficients(cc.fridgeSlowFilter);
+	fridgeSensor.setSlopeFilterCoefficients(cc.fridgeSlopeFilter);
+	beerSensor.setFastFilterCoefficients(cc.beerFastFilter);
+	beerSensor.setSlowFilterCoefficients(cc.beerSlowFilter);
+	beerSensor.setSlopeFilterCoefficients(cc.beerSlopeFilter);
+	fridgeSensor.setFastFilterSections(cc.fridgeFastSections);
+	fridgeSensor.setSlowFilterSections(cc.fridgeSlowSections);
+	fridgeSensor.setSlopeFilterSections(cc.fridgeSlopeSections);
+	beerSensor.setFastFilterSections(cc.beerFastSections);
+	beerSensor.setSlowFilterSections(cc.beerSlowSections);
+	beerSensor.setSlopeFilterSections(cc.beerSlopeSections);
 }
 
 void TempControl::loadDefaultConstants(void){
@@ -458,21 +498,39 @@ void TempControl::loadDefaultConstants(void){
 	beerSensor.setSlowFilterCoefficients(cc.beerSlowFilter);
 	cc.beerSlopeFilter = 4u;
 	beerSensor.setSlopeFilterCoefficients(cc.beerSlopeFilter);
+	
+	// Number of cascaded sections per filter
+	cc.fridgeFastSections = CASCADED_FILTER_DEFAULT_SECTIONS;
+	fridgeSensor.setFastFilterSections(cc.fridgeFastSections);
+	cc.fridgeSlowSections = CASCADED_FILTER_DEFAULT_SECTIONS;
+	fridgeSensor.setSlowFilterSections(cc.fridgeSlowSections);
+	cc.fridgeSlopeSections = CASCADED_FILTER_DEFAULT_SECTIONS;
+	fridgeSensor.setSlopeFilterSections(cc.fridgeSlopeSections);
+	cc.beerFastSections = CASCADED_FILTER_DEFAULT_SECTIONS;
+	beerSensor.setFastFilterSections(cc.beerFastSections);
+	cc.beerSlowSections = CASCADED_FILTER_DEFAULT_SECTIONS;
+	beerSensor.setSlowFilterSections(cc.beerSlowSections);
+	cc.beerSlopeSections = CASCADED_FILTER_DEFAULT_SECTIONS;
+	beerSensor.setSlopeFilterSections(cc.beerSlopeSections);
+	
+	cc.pidInput = PID_INPUT_FILTERS;
 	storeConstants();
 }
 
 void TempControl::loadSettingsAndConstants(void){
-	if(eeprom_read_byte((unsigned char *) EEPROM_IS_INITIALIZED_ADDRESS) != 1){
-		// EEPROM is not initialized, use default settings
+	if(eeprom_read_byte((unsigned char *) EEPROM_IS_INITIALIZED_ADDRESS) != EEPROM_FORMAT_VERSION){
+		// EEPROM is not initialized or has an older format, use default settings
 		loadDefaultSettings();
 		loadDefaultConstants();
-		eeprom_write_byte((unsigned char *) EEPROM_IS_INITIALIZED_ADDRESS, 1);
+		eeprom_write_byte((unsigned char *) EEPROM_IS_INITIALIZED_ADDRESS, EEPROM_FORMAT_VERSION);
 		storeSettings();
 		storeConstants();
+		deviceRegistry.clear();
 	}
 	else{
 		loadSettings();
 		loadConstants();
+		deviceRegistry.load();
 	}
 }
 
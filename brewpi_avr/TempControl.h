@@ -22,6 +22,7 @@
 #define CONTROLLER_H_
 
 #include "TempSensor.h"
+#include "KalmanEstimator.h"
 #include "pins.h"
 #include "temperatureFormats.h"
 
@@ -41,6 +42,16 @@
 #define COOL_PEAK_DETECT_TIME 1800u
 #define HEAT_PEAK_DETECT_TIME 900u
 
+// Set to 1 to run a Kalman estimator of the beer temperature and slope next to the filters, see KalmanEstimator.h.
+// ControlConstants.pidInput selects whether the PID uses the filters or the estimator.
+#ifndef TEMP_CONTROL_KALMAN
+#define TEMP_CONTROL_KALMAN 1
+#endif
+
+// values of ControlConstants.pidInput
+#define PID_INPUT_FILTERS 0 // slow filter and slope of the beer sensor
+#define PID_INPUT_KALMAN 1 // temperature and slope of the Kalman estimator
+
 // These two structs are stored in and loaded from EEPROM
 struct ControlSettings{
 	char mode;
@@ -87,11 +98,25 @@ struct ControlConstants{
 	uint8_t beerFastFilter;	// for display and logging
 	uint8_t beerSlowFilter;	// for on/off control algorithm
 	uint8_t beerSlopeFilter;	// for PID calculation
+	// number of cascaded sections of each filter, 1 to CASCADED_FILTER_MAX_SECTIONS
+	uint8_t fridgeFastSections;
+	uint8_t fridgeSlowSections;
+	uint8_t fridgeSlopeSections;
+	uint8_t beerFastSections;
+	uint8_t beerSlowSections;
+	uint8_t beerSlopeSections;
+	uint8_t pidInput; // PID_INPUT_FILTERS or PID_INPUT_KALMAN
 };
 
+// Written to EEPROM_IS_INITIALIZED_ADDRESS. Change it when the layout of the structs below changes,
+// so EEPROM written by an older version is reinitialized with the defaults.
+#define EEPROM_FORMAT_VERSION 3
+
 #define EEPROM_IS_INITIALIZED_ADDRESS 0
 #define EEPROM_CONTROL_SETTINGS_ADDRESS (EEPROM_IS_INITIALIZED_ADDRESS+sizeof(uint8_t))
 #define EEPROM_CONTROL_CONSTANTS_ADDRESS (EEPROM_CONTROL_SETTINGS_ADDRESS+sizeof(ControlSettings))
+#define EEPROM_DEVICES_ADDRESS (EEPROM_CONTROL_CONSTANTS_ADDRESS+sizeof(ControlConstants))
+#define EEPROM_CHECKPOINT_ADDRESS (EEPROM_DEVICES_ADDRESS+MAX_DEVICES*sizeof(DeviceConfig))
 
 #define	MODE_FRIDGE_CONSTANT 'f'
 #define MODE_BEER_CONSTANT 'b'
@@ -122,6 +147,7 @@ class TempControl{
 	static void reset(void);
 	
 	static void updateTemperatures(void);
+	static void pollSensors(void);
 	static void updatePID(void);
 	static void updateState(void);
 	static void updateOutputs(void);
@@ -165,6 +191,9 @@ class TempControl{
 	public:
 	static TempSensor beerSensor;
 	static TempSensor fridgeSensor;
+#if TEMP_CONTROL_KALMAN
+	static KalmanEstimator beerEstimator;
+#endif
 	
 	// Control parameters
 	static ControlConstants cc;
@@ -22,95 +22,527 @@
 #include "DallasTemperature.h"
 #include "PiLink.h"
 #include <limits.h>
+#include <string.h>
 #include "Ticks.h"
 
 void TempSensor::init(void){
-	// give reset pulse to temp sensors
-	oneWire->reset();
+	if(state != SENSOR_IDLE){
+		return; // sensor is already initialized or waiting for its first reading
+	}
+	retryInterval = 1;
+	retryCountdown = 0;
+	if(bus->conversionComplete()){
+		retry();
+	}
+}
+
+// Make one attempt to find the device, without waiting for anything. Only call when no conversion is running on the bus.
+void TempSensor::retry(void){
+	if(!reconnect()){
+		backOff();
+	}
+}
+
+// Wait twice as long as last time before the next attempt to find the device
+void TempSensor::backOff(void){
+	if(retryInterval < TEMP_SENSOR_RETRY_MAX){
+		retryInterval <<= 1;
+	}
+	retryCountdown = retryInterval;
+}
 
-	// get sensor address
-	if (!sensor->getAddress(sensorAddress, 0)){
+// Returns true when the device was found and its first conversion was started
+bool TempSensor::reconnect(void){
+	// Use the device that was stored in EEPROM. Only search the bus when that device is missing.
+	DeviceConfig * config = deviceRegistry.findRole(role, pinNr);
+	if(config != 0 && sensor->isConnected(config->address)){
+		memcpy(sensorAddress, config->address, sizeof(DeviceAddress));
+	}
+	else if(!discover()){
 		// error no sensor found
 		if(ticks.seconds() < 4){
 			// only log this debug message at startup
 			piLink.debugMessage(PSTR("Unable to find address for sensor on pin %d"), pinNr);
 		}
+		return false;
+	}
+	if(!applyResolution()){
+		return false; // device did not respond
+	}
+	
+	// The filters are initialized with the first reading after debouncing, in update().
+	debounceCount = TEMP_SENSOR_DEBOUNCE_SAMPLES;
+	requestConversion();
+	return true;
+}
+
+// Check one device on the bus per call, so searching a bus with many devices is spread over multiple calls.
+// A temperature sensor that is not used by another sensor is stored in the device registry for this role.
+bool TempSensor::discover(void){
+	DeviceAddress address;
+	if(!oneWire->search(address)){
+		return false; // no (more) devices, next search starts from the first device again
+	}
+	if(!sensor->validAddress(address)){
+		return false;
+	}
+	if(address[0] != DS18B20MODEL && address[0] != DS18S20MODEL && address[0] != DS1822MODEL){
+		return false; // not a temperature sensor
+	}
+	if(!deviceRegistry.isAvailable(address, role, pinNr)){
+		return false; // device is used by another sensor
+	}
+	deviceRegistry.assign(address, role, pinNr);
+	memcpy(sensorAddress, address, sizeof(DeviceAddress));
+	piLink.debugMessage(PSTR("New sensor found on pin %d"), pinNr);
+	return true;
+}
+
+bool TempSensor::applyResolution(void){
+	// The resolution changes with the control state, so it is only written to the scratchpad, not to the EEPROM
+	// of the sensor. After a power cycle the sensor loads its EEPROM and gets the resolution again in reconnect().
+	if(!sensor->setResolution(sensorAddress, targetResolution, false)){
+		return false;
+	}
+	resolution = (sensorAddress[0] == DS18S20MODEL) ? 9 : targetResolution; // DS18S20 has a fixed resolution
+	return true;
+}
+
+uint16_t TempSensor::getConversionTime(void){
+	if(resolution == 0){
+		return 0;
+	}
+	if(sensorAddress[0] == DS18S20MODEL){
+		return DallasTemperature::millisToWaitForConversion(12); // always takes the max conversion time
+	}
+	return DallasTemperature::millisToWaitForConversion(resolution);
+}
+
+#if ONEWIRE_TIMER
+TempSensor * TempSensor::reader = 0;
+bool TempSensor::readFast;
+uint8_t TempSensor::readCommand[10];
+uint8_t TempSensor::readBuffer[9];
+
+// Start reading the scratchpad in the background. poll() collects it when the transaction is done,
+// so the main loop only spends the time to start and collect the read.
+void TempSensor::startReading(void){
+	if(reader != 0){
+		return; // another sensor is reading, try again on the next poll
+	}
+	uint8_t readCount = 9;
+#if TEMP_SENSOR_FAST_READ
+	readFast = fastReadDue();
+	if(readFast){
+		readCount = 2; // the next transaction starts with a reset, which stops the device from sending the rest
+	}
+	else{
+		fullReadCounter = TEMP_SENSOR_FULL_READ_INTERVAL - 1;
+	}
+#else
+	readFast = false;
+#endif
+	readCommand[0] = 0x55; // Match ROM
+	memcpy(&readCommand[1], sensorAddress, sizeof(DeviceAddress));
+	readCommand[9] = READSCRATCH;
+	if(!oneWire->startTransaction(true, readCommand, sizeof(readCommand), readBuffer, readCount)){
+		// no background read is running, so the wire is held low
+		stats.presenceErrors++;
+		setReading(DEVICE_DISCONNECTED_FIXED);
 		return;
 	}
-	sensor->setResolution(sensorAddress, 12);
-	sensor->setWaitForConversion(false);
-		
-	sensor->requestTemperatures();
-	lastRequestTime = ticks.millis();
-	wait.millis(750); // delay 750ms for conversion time
-	fixed7_9 temperature = DEVICE_DISCONNECTED;
-	while(temperature == DEVICE_DISCONNECTED){
-		temperature = sensor->getTempRaw(sensorAddress);
-		if(ticks.millis() - lastRequestTime > 2000){
-			connected = false; // sensor disconnected
-			return;
-		}
-	}
-	sensor->requestTemperatures();
-	wait.millis(750);
-	temperature = sensor->getTempRaw(sensorAddress); // read again. First read is not accurate
-	connected = true;
-	temperature = constrain(temperature, ((int) INT_MIN)>>5, ((int) INT_MAX)>>5)<<5; // sensor returns 12 bits with 4 fraction bits. Store with 9 fraction bits
-	fastFilter.init(temperature);
-	slowFilter.init(temperature);
-	slopeFilter.init(0);
-	prevOutputForSlope = slowFilter.readOutputDoublePrecision();
+	reader = this;
+	state = SENSOR_READING;
 }
 
+void TempSensor::finishReading(void){
+	reader = 0;
+	bool present = OneWire::transactionPresence();
+#if TEMP_SENSOR_FAST_READ
+	if(readFast){
+		fixed7_9 temperature = checkFastReading(readBuffer[0] | (readBuffer[1] << 8), present);
+		if(temperature != DEVICE_DISCONNECTED_FIXED){
+			setReading(temperature);
+		}
+		else{
+			state = SENSOR_CONVERTING; // the next poll starts a full read
+		}
+		return;
+	}
+#endif
+	setReading(checkScratchPad(readBuffer, present));
+}
 
-void TempSensor::update(void){
-	if((ticks.millis()-lastRequestTime) > 5000){ // if last request is longer than 5 seconds ago, request again and delay
-		sensor->requestTemperatures();
-		lastRequestTime = ticks.millis();
-		wait.millis(750); // wait 750 ms (18B20 max conversion time)
-	}
-	fixed7_9 temperature = sensor->getTempRaw(sensorAddress);
-	if(temperature == DEVICE_DISCONNECTED){
-		// device disconnected. Don't update filters.  Log a debug message.
-		if(connected == true){
-			piLink.debugMessage(PSTR("Temperature sensor on pin %d disconnected"), pinNr);
-		}			
-		connected = false;
+#else
+
+void TempSensor::startReading(void){
+	setReading(readTemperature());
+}
+
+// Read the temperature of the device. Returns DEVICE_DISCONNECTED_FIXED when it could not be read.
+fixed7_9 TempSensor::readTemperature(void){
+#if TEMP_SENSOR_FAST_READ
+	if(fastReadDue()){
+		int16_t raw = sensor->getTempRawFast(sensorAddress);
+		fixed7_9 temperature = checkFastReading(raw, sensor->getLastReadResult() == READ_OK);
+		if(temperature != DEVICE_DISCONNECTED_FIXED){
+			return temperature;
+		}
+	}
+	fullReadCounter = TEMP_SENSOR_FULL_READ_INTERVAL - 1;
+#endif
+	stats.fullReads++;
+	fixed7_9 temperature = sensor->getTempFixed(sensorAddress);
+	countReadResult();
+	return temperature;
+}
+#endif
+
+#if TEMP_SENSOR_FAST_READ
+// Returns true when the next read can be a fast read of only the temperature bytes
+bool TempSensor::fastReadDue(void){
+	// A fast read needs a filtered value to check against. The DS18S20 needs the full scratchpad for its extended resolution.
+	if(connected && sensorAddress[0] != DS18S20MODEL && fullReadCounter > 0){
+		fullReadCounter--;
+		return true;
+	}
+	return false;
+}
+
+// Check the temperature bytes of a fast read. Returns DEVICE_DISCONNECTED_FIXED when the reading is rejected,
+// the next read is then a full read.
+fixed7_9 TempSensor::checkFastReading(int16_t raw, bool present){
+	raw &= ~((1 << (12 - resolution)) - 1); // clear the undefined bits
+	fixed7_9 temperature = constrain(raw, ((int) INT_MIN)>>5, ((int) INT_MAX)>>5)<<5;
+	// compare with the last reading, the filtered temperature lags behind when the temperature changes
+	long difference = (long) temperature - read();
+	long window = max(TEMP_SENSOR_PLAUSIBLE_WINDOW, (long) TEMP_SENSOR_PLAUSIBLE_STEPS << (17 - resolution)); // a step is 1<<(17-bits)
+	// without a presence pulse the bytes read as 0xFF, which is a plausible -0.06 degrees
+	if(present && difference <= window && difference >= -window){
+		stats.fastReads++;
+		return temperature;
+	}
+	if(!present){
+		stats.presenceErrors++;
+	}
+	stats.rejectedReads++; // could be a bit error or a disconnected device, check with a full read
+	fullReadCounter = 0;
+	return DEVICE_DISCONNECTED_FIXED;
+}
+#endif
+
+// Check a full scratchpad that was read without DallasTemperature. Returns DEVICE_DISCONNECTED_FIXED when it is not valid.
+fixed7_9 TempSensor::checkScratchPad(uint8_t * scratchPad, bool present){
+	stats.fullReads++;
+	if(!present){
+		stats.presenceErrors++;
+		return DEVICE_DISCONNECTED_FIXED;
+	}
+	if(OneWire::crc8(scratchPad, 8) != scratchPad[SCRATCHPAD_CRC]){
+		stats.crcErrors++;
+		return DEVICE_DISCONNECTED_FIXED;
+	}
+	return sensor->calculateTemperatureFixed(sensorAddress, scratchPad);
+}
+
+// Count the errors of the last scratchpad read
+void TempSensor::countReadResult(void){
+	uint8_t result = sensor->getLastReadResult();
+	if(result == READ_NO_PRESENCE){
+		stats.presenceErrors++;
+	}
+	else if(result == READ_CRC_ERROR){
+		stats.crcErrors++;
+	}
+}
+
+void TempSensor::requestConversion(void){
+	bus->requestConversion(); // only starts a new conversion when the bus is not converting yet
+	state = SENSOR_CONVERTING;
+}
+
+void TempSensor::poll(void){
+	if(state == SENSOR_IDLE){
+		// try to find a missing device when it is time and the bus is free
+		if(retryCountdown == 0 && bus->conversionComplete()){
+			unsigned long startTime = ticks.micros();
+			retry();
+			recordReadTime(ticks.micros() - startTime);
+		}
 		return;
 	}
+#if ONEWIRE_TIMER
+	if(state == SENSOR_READING){
+		if(!OneWire::transactionBusy()){
+			unsigned long startTime = ticks.micros();
+			finishReading();
+			recordReadTime(ticks.micros() - startTime);
+		}
+		return;
+	}
+#endif
+	if(state != SENSOR_CONVERTING){
+		return;
+	}
+	if(bus->conversionComplete()){
+		unsigned long startTime = ticks.micros();
+#if TEMP_SENSOR_EVENT_MODE
+		if(inAlarmWindow()){
+			state = SENSOR_READY; // the last reading is still valid
+		}
+		else{
+			startReading();
+		}
+#else
+		startReading();
+#endif
+		recordReadTime(ticks.micros() - startTime);
+	}
+}
+
+#if TEMP_SENSOR_EVENT_MODE
+// Returns true when the read can be skipped, because the device was not found by the alarm search of the bus
+bool TempSensor::inAlarmWindow(void){
+	if(!eventMode || eventReadsLeft == 0){
+		return false;
+	}
+	eventReadsLeft--;
+	if(bus->hasAlarm(sensorAddress)){
+		return false;
+	}
+	skippedReads++;
+	return true;
+}
+
+// Set the alarm window of the device around the last reading. The device compares whole degrees:
+// it has an alarm when the integer part of the temperature is >= TH or <= TL.
+void TempSensor::setAlarmWindow(void){
+	long window = (long) TEMP_SENSOR_EVENT_WINDOW << 9;
+	int8_t high = (reading + window) >> 9; // alarm when the temperature rises by up to TEMP_SENSOR_EVENT_WINDOW
+	int8_t low = ((reading - window + 511) >> 9) - 1; // alarm when the temperature drops by up to TEMP_SENSOR_EVENT_WINDOW
+	if(sensor->setAlarmWindow(sensorAddress, low, high)){
+		eventReadsLeft = TEMP_SENSOR_EVENT_REFRESH_INTERVAL;
+	}
+	else{
+		eventReadsLeft = 0; // read again after the next conversion
+	}
+}
+#endif
+
+// Poll several sensors. Sensors on different pins of the same port that can be read now are read in lock-step:
+// their scratchpads are read in parallel, in the bus time of a single read. The other sensors are polled one by one.
+void TempSensor::pollAll(TempSensor * const * sensors, uint8_t count){
+#if TEMP_SENSOR_LOCK_STEP
+	OneWireLockStep lockStep;
+	TempSensor * group[ONEWIRE_MAX_LOCKSTEP_PINS];
+	for(uint8_t i=0; i<count; i++){
+		TempSensor * tempSensor = sensors[i];
+#if TEMP_SENSOR_EVENT_MODE
+		if(tempSensor->eventMode){
+			continue; // skips most reads, poll() checks the alarm search first
+		}
+#endif
+		if(tempSensor->state == SENSOR_CONVERTING && tempSensor->bus->conversionComplete() && lockStep.addPin(tempSensor->pinNr)){
+			group[lockStep.getNumPins()-1] = tempSensor;
+		}
+	}
+	if(lockStep.getNumPins() > 1){
+		readLockStep(lockStep, group);
+	}
+#endif
+	for(uint8_t i=0; i<count; i++){
+		sensors[i]->poll();
+	}
+}
+
+#if TEMP_SENSOR_LOCK_STEP
+void TempSensor::readLockStep(OneWireLockStep & lockStep, TempSensor * const * group){
+	uint8_t numPins = lockStep.getNumPins();
+	uint8_t data[ONEWIRE_MAX_LOCKSTEP_PINS];
+	uint8_t scratchPad[ONEWIRE_MAX_LOCKSTEP_PINS][9];
 	
+	// The bytes are read on all pins at once, so the group does a fast read only when all sensors can
+	uint8_t readCount = 9;
+#if TEMP_SENSOR_FAST_READ
+	bool fast = true;
+	for(uint8_t i=0; i<numPins; i++){
+		fast = group[i]->fastReadDue() && fast;
+	}
+	if(fast){
+		readCount = 2;
+	}
 	else{
-		if(connected == false){
-			wait.millis(2000); // delay for two seconds to be sure sensor is correctly inserted
-			init(); // was disconnected, initialize again
-			piLink.debugMessage(PSTR("Temperature sensor on pin %d reconnected"), pinNr);
-			temperature = sensor->getTempRaw(sensorAddress); // re-read temperature after proper initialization
+		for(uint8_t i=0; i<numPins; i++){
+			group[i]->fullReadCounter = TEMP_SENSOR_FULL_READ_INTERVAL - 1;
 		}
 	}
-	temperature = constrain(temperature, ((int) INT_MIN)>>5, ((int) INT_MAX)>>5)<<5; // sensor returns 12 bits with 4 fraction bits. Store with 9 fraction bits
+#endif
+	unsigned long startTime = ticks.micros();
 	
-		
-	fastFilter.add(temperature);
-	slowFilter.add(temperature);
+	uint8_t presence = lockStep.reset();
+	// Match ROM, with the address of its own sensor on each pin
+	memset(data, 0x55, sizeof(data));
+	lockStep.write(data);
+	for(uint8_t b=0; b<8; b++){
+		for(uint8_t i=0; i<numPins; i++){
+			data[i] = group[i]->sensorAddress[b];
+		}
+		lockStep.write(data);
+	}
+	memset(data, READSCRATCH, sizeof(data));
+	lockStep.write(data);
+	for(uint8_t b=0; b<readCount; b++){
+		lockStep.read(data);
+		for(uint8_t i=0; i<numPins; i++){
+			scratchPad[i][b] = data[i];
+		}
+	}
+	// the devices stop sending the rest of the scratchpad at a reset
+	lockStep.reset();
+	unsigned long pollTime = ticks.micros() - startTime;
+	
+	for(uint8_t i=0; i<numPins; i++){
+		TempSensor * tempSensor = group[i];
+		bool present = presence & (1<<i);
+		tempSensor->recordReadTime(pollTime);
+#if TEMP_SENSOR_FAST_READ
+		if(fast){
+			fixed7_9 temperature = tempSensor->checkFastReading(scratchPad[i][0] | (scratchPad[i][1] << 8), present);
+			if(temperature != DEVICE_DISCONNECTED_FIXED){
+				tempSensor->setReading(temperature);
+			}
+			// else the sensor stays converting and poll() does a full read
+			continue;
+		}
+#endif
+		tempSensor->setReading(tempSensor->checkScratchPad(scratchPad[i], present));
+	}
+}
+#endif
+
+// Store a reading collected by poll(), or handle a disconnected device when the reading is DEVICE_DISCONNECTED_FIXED
+void TempSensor::setReading(fixed7_9 temperature){
+	if(temperature == DEVICE_DISCONNECTED_FIXED){
+		// device disconnected. Don't update filters. Log a debug message.
+		if(connected == true){
+			piLink.debugMessage(PSTR("Temperature sensor on pin %d disconnected"), pinNr);
+			stats.disconnects++;
+			retryInterval = 1; // try again on the next update
+			retryCountdown = retryInterval;
+		}
+		else{
+			backOff(); // lost again before it was debounced
+		}
+		connected = false;
+		resolution = 0;
+#if TEMP_SENSOR_EVENT_MODE
+		eventReadsLeft = 0;
+#endif
+		state = SENSOR_IDLE; // poll() tries to find the sensor again
+	}
+	else{
+		reading = temperature;
+		state = SENSOR_READY;
+#if TEMP_SENSOR_EVENT_MODE
+		if(eventMode){
+			setAlarmWindow();
+		}
+#endif
+	}
+}
+
+void TempSensor::recordReadTime(unsigned long readTime){
+	if(readTime > 0xFFFF){
+		readTime = 0xFFFF; // the max fits in 16 bits, longer reads are counted as 65.5 ms
+	}
+	if(readTime > stats.maxReadTime){
+		stats.maxReadTime = readTime;
+	}
+	stats.totalReadTime += readTime;
+	if(++stats.readCount == 0x8000){
+		// halve both, so the mean stays the same and nothing overflows
+		stats.readCount >>= 1;
+		stats.totalReadTime >>= 1;
+	}
+}
+
+void TempSensor::update(void){
+	poll(); // collect the reading if the main loop has not done so yet
+	if(state == SENSOR_IDLE && retryCountdown > 0){
+		retryCountdown--;
+	}
+	if(state != SENSOR_READY){
+		return; // no new reading
+	}
+	if(debounceCount > 0){
+		debounceCount--;
+		requestConversion();
+		return;
+	}
+	fixed7_9 temperature = reading;
 	
-	// update slope filter every 12 samples.
-	// averaged differences will give the slope. Use the slow filter as input
-	updateCounter--;
-	// initialize first read for slope filter after (255-13) seconds. This prevents an influence for the startup inaccuracy.
-	if(updateCounter == 13){
-		// only happens once after startup.
-		prevOutputForSlope = slowFilter.readOutputDoublePrecision();
-	}
-	if(updateCounter == 0){
-		slopeFilter.addDoublePrecision(slowFilter.readOutputDoublePrecision() - prevOutputForSlope);
-		prevOutputForSlope = slowFilter.readOutputDoublePrecision();
-		updateCounter = 12;
+	if(connected == false){
+		// first valid reading after (re)initialization and debouncing
+		retryInterval = 1;
+		if(stats.disconnects != 0){
+			stats.reconnects++;
+		}
+		initFilters(temperature);
+		connected = true;
+		piLink.debugMessage(PSTR("Temperature sensor on pin %d connected"), pinNr);
+	}
+	else{
+		fastFilter.add(temperature);
+		slowFilter.add(temperature);
+		// the slope filter averages the slow filter output over TEMP_SENSOR_SLOPE_DECIMATION samples
+		// and filters the differences between the averages
+#if TEMP_SENSOR_SLOPE_REGRESSION
+		slopeEstimator.add(temperature);
+#else
+		slopeFilter.addDoublePrecision(slowFilter.readOutputDoublePrecision());
+#endif
 	}
 		
+	// change the resolution before the next conversion, when no other sensor has started it yet
+	if(resolution != targetResolution && sensorAddress[0] != DS18S20MODEL && bus->conversionComplete()){
+		applyResolution();
+	}
 	// already send request for next read
-	sensor->requestTemperatures();
-	lastRequestTime = ticks.millis();
+	requestConversion();
+}
+
+void TempSensor::initFilters(fixed7_9 temperature){
+	fastFilter.init(temperature);
+#if TEMP_SENSOR_CHECKPOINT
+	fixed7_9 restored = restorePoint.temperature;
+	restorePoint.temperature = INT_MIN; // only restore once
+	if(restored != INT_MIN && abs((long) temperature - restored) <= TEMP_SENSOR_CHECKPOINT_TOLERANCE){
+		fixed7_9 slope = restorePoint.slope;
+		slowFilter.init(restored);
+#if TEMP_SENSOR_SLOPE_REGRESSION
+		slopeEstimator.init(restored, slope);
+#else
+		// the slope filter output is the change per TEMP_SENSOR_SLOPE_DECIMATION samples
+		slopeFilter.init(restored, (((fixed7_25) slope) << 16) / (3600/TEMP_SENSOR_SLOPE_DECIMATION));
+#endif
+		piLink.debugMessage(PSTR("Filters of sensor on pin %d restored from checkpoint"), pinNr);
+		return;
+	}
+#endif
+	slowFilter.init(temperature);
+#if TEMP_SENSOR_SLOPE_REGRESSION
+	slopeEstimator.init(temperature);
+#else
+	slopeFilter.init(temperature);
+#endif
+}
+
+#if TEMP_SENSOR_CHECKPOINT
+void TempSensor::getCheckpoint(TempSensorCheckpoint & checkpoint){
+	checkpoint.temperature = connected ? slowFilter.readOutput() : INT_MIN;
+	checkpoint.slope = readSlope();
 }
+#endif
 
 fixed7_9 TempSensor::read(void){
 	return fastFilter.readInput(); //return most recent unfiltered value
@@ -121,8 +553,12 @@ fixed7_9 TempSensor::readFastFiltered(void){
 }
 
 fixed7_9 TempSensor::readSlope(void){
-	// return slope per hour. Multiply by 300 (1h/12s), shift to single precision
+#if TEMP_SENSOR_SLOPE_REGRESSION
+	return slopeEstimator.readSlope();
+#else
+	// return slope per hour. Multiply by 3600s / decimation (300 for 12s), shift to single precision
 	fixed7_25 doublePrecision = slopeFilter.readOutputDoublePrecision();
-	return (doublePrecision*300)>>16;
+	return (doublePrecision*(3600/TEMP_SENSOR_SLOPE_DECIMATION))>>16;
+#endif
 }
 
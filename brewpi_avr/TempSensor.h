@@ -22,34 +22,154 @@
 #define SENSORS_H_
 
 #include "CascadedFilter.h"
+#include "DecimatingFilter.h"
+#include "SlopeEstimator.h"
 #include "OneWire.h"
 #include "DallasTemperature.h"
+#include "TempSensorBus.h"
+#include "DeviceRegistry.h"
 #include "temperatureFormats.h"
 #include "pins.h"
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+// Resolution in bits for accurate readings and for fast readings with a short conversion time
+#define TEMP_SENSOR_RESOLUTION_FULL 12
+#define TEMP_SENSOR_RESOLUTION_FAST 10
+
+// Set to 1 to read only the temperature bytes of the scratchpad, without CRC. A full read with CRC is done
+// every TEMP_SENSOR_FULL_READ_INTERVAL samples, and whenever a fast reading is outside the plausible window.
+#ifndef TEMP_SENSOR_FAST_READ
+#define TEMP_SENSOR_FAST_READ 1
+#endif
+#define TEMP_SENSOR_FULL_READ_INTERVAL 10
+// Max difference between a fast reading and the last reading: 0.25 degree in fixed7_9, but at least
+// TEMP_SENSOR_PLAUSIBLE_STEPS steps of the resolution. A bit error that changes the reading less than this is accepted.
+#define TEMP_SENSOR_PLAUSIBLE_WINDOW (1<<7)
+#define TEMP_SENSOR_PLAUSIBLE_STEPS 2
+
+// Set to 1 to read sensors on different pins of the same port at the same time, see TempSensor::pollAll()
+// The lock-step reader drives the pins itself, so it can't be used with the timer driven OneWire.
+#ifndef TEMP_SENSOR_LOCK_STEP
+#define TEMP_SENSOR_LOCK_STEP !ONEWIRE_TIMER
+#endif
+#if TEMP_SENSOR_LOCK_STEP && ONEWIRE_TIMER
+#error "TEMP_SENSOR_LOCK_STEP can't be used with ONEWIRE_TIMER"
+#endif
+
+// Number of readings that are discarded after a device is found, before its readings are used. The first reading is
+// not accurate, and a probe with a bad contact will usually drop out again before its readings reach the filters.
+#define TEMP_SENSOR_DEBOUNCE_SAMPLES 2
+// Max number of updates (seconds) between attempts to find a missing device. The interval doubles after each failed attempt.
+#define TEMP_SENSOR_RETRY_MAX 64
+
+// In event mode, the alarm window of the device is set to TEMP_SENSOR_EVENT_WINDOW degrees around the last reading.
+// The device is only read when it is found by the alarm search, and at least every TEMP_SENSOR_EVENT_REFRESH_INTERVAL
+// conversions to notice a disconnected device or a device that lost its window after a power cycle.
+#define TEMP_SENSOR_EVENT_WINDOW 1
+#define TEMP_SENSOR_EVENT_REFRESH_INTERVAL 60
+
+// The slow filter runs once every TEMP_SENSOR_SLOW_DECIMATION samples, on the average of these samples.
+// The slope filter runs every TEMP_SENSOR_SLOPE_DECIMATION samples on the change of the averaged slow filter output.
+#ifndef TEMP_SENSOR_SLOW_DECIMATION
+#define TEMP_SENSOR_SLOW_DECIMATION 1
+#endif
+#ifndef TEMP_SENSOR_SLOPE_DECIMATION
+#define TEMP_SENSOR_SLOPE_DECIMATION 12
+#endif
+
+// Set to 1 to estimate the slope with a least squares fit over a window of the readings, see SlopeEstimator.h.
+// It follows a change in slope much faster than the slope filter, at the cost of 2 bytes of RAM per point.
+#ifndef TEMP_SENSOR_SLOPE_REGRESSION
+#define TEMP_SENSOR_SLOPE_REGRESSION 0
+#endif
+
+// Set to 1 to store the slow filter output and the slope in EEPROM every TEMP_SENSOR_CHECKPOINT_INTERVAL seconds,
+// see SensorCheckpoint.h. After a reset, the filters start from the checkpoint instead of from a single reading,
+// when the first reading is within TEMP_SENSOR_CHECKPOINT_TOLERANCE of the stored temperature.
+#ifndef TEMP_SENSOR_CHECKPOINT
+#define TEMP_SENSOR_CHECKPOINT 1
+#endif
+#define TEMP_SENSOR_CHECKPOINT_INTERVAL 600
+#define TEMP_SENSOR_CHECKPOINT_TOLERANCE 128 // 0.25 degree
+
+// Health counters of a sensor, to spot failing cables and probes. The counters wrap around, compare two samples.
+struct TempSensorStats{
+	uint16_t fastReads; // reads of only the temperature bytes, without CRC check
+	uint16_t fullReads; // reads of the full scratchpad, with CRC check
+	uint16_t rejectedReads; // fast reads that failed the plausibility check or had no presence pulse
+	uint16_t crcErrors; // full reads with a CRC mismatch
+	uint16_t presenceErrors; // reads without a presence pulse
+	uint16_t disconnects;
+	uint16_t reconnects; // device found and debounced again after a disconnect
+	uint16_t maxReadTime; // longest time in microseconds that poll() kept the main loop busy with the bus, at most 0xFFFF
+	uint16_t readCount; // number of bus transactions in totalReadTime. Both are halved to prevent overflow.
+	uint32_t totalReadTime; // in microseconds
+	// The times are measured with ticks.micros(). With TICKS_VIRTUAL, the clock does not move during a poll, so
+	// they stay 0. The simulated bus counts its own time, see OneWireSimBus::busTime.
+};
+
+// Filter state to warm start a sensor after a reset
+struct TempSensorCheckpoint{
+	fixed7_9 temperature; // slow filter output, INT_MIN when the sensor was not connected
+	fixed7_9 slope; // per hour
+};
+
+// Each sensor cycles through these states. Nothing waits for the sensor.
+enum sensorStates{
+	SENSOR_IDLE, // no conversion in progress: not initialized or disconnected. poll() tries to find the device again.
+	SENSOR_CONVERTING, // conversion requested, poll() collects the reading when it is complete
+#if ONEWIRE_TIMER
+	SENSOR_READING, // the scratchpad is read in the background, poll() collects it when the transaction is done
+#endif
+	SENSOR_READY // reading collected, update() adds it to the filters and requests the next conversion
+};
 
 class TempSensor{
 	public:
-	TempSensor(const uint8_t pinNumber) : pinNr(pinNumber){
-		lastRequestTime = 0;
+	TempSensor(const uint8_t sensorRole, TempSensorBus & sensorBus) : role(sensorRole), pinNr(sensorBus.getPin()){
 		connected = 0;
-		updateCounter = 255; // first update for slope filter after (255-13s)
-		oneWire = new OneWire(pinNr);
-		sensor = new DallasTemperature(oneWire);
+		state = SENSOR_IDLE;
+		debounceCount = 0;
+		retryInterval = 1;
+		retryCountdown = 0;
+		memset(&stats, 0, sizeof(stats));
+		fullReadCounter = 0;
+#if TEMP_SENSOR_EVENT_MODE
+		eventMode = false;
+		eventReadsLeft = 0;
+		skippedReads = 0;
+#endif
+		resolution = 0;
+		targetResolution = TEMP_SENSOR_RESOLUTION_FULL;
+#if TEMP_SENSOR_CHECKPOINT
+		restorePoint.temperature = INT_MIN;
+#endif
+		slowFilter.setDecimation(TEMP_SENSOR_SLOW_DECIMATION);
+#if !TEMP_SENSOR_SLOPE_REGRESSION
+		slopeFilter.setDecimation(TEMP_SENSOR_SLOPE_DECIMATION);
+		slopeFilter.setDifferentiate(true);
+#endif
+		// sensors on the same pin share a bus
+		bus = &sensorBus;
+		oneWire = bus->getOneWire();
+		sensor = bus->getSensor();
+		bus->addSensor(this);
 	};
 		
 	~TempSensor(){
-		delete oneWire;
-		delete sensor;
 	};
 		
-	void init();
+	void init(); // find the device and start the first conversion. When the device is missing, poll() keeps trying.
 	
 	bool isConnected(void){
 		return connected;
 	}
 	
-	void update(void);
+	void update(void); // process a new reading and start the next conversion. Call once per second.
+	void poll(void); // collect the reading when the conversion is complete, or try to find a missing device. Call as often as possible.
+	static void pollAll(TempSensor * const * sensors, uint8_t count); // poll() for several sensors, in lock-step when possible
 	fixed7_9 read(void);
 	fixed7_9 readFastFiltered(void);
 
@@ -70,28 +190,163 @@ class TempSensor{
 		fastFilter.setCoefficients(b);
 	}
 	
+	// b is given for a filter that runs every second, it is lowered when the slow filter is decimated
 	void setSlowFilterCoefficients(uint8_t b){
-		slowFilter.setCoefficients(b);
+		slowFilter.setCoefficientsForInputRate(b);
 	}
 
+	// The slope filter settings are ignored when the slope is estimated with TEMP_SENSOR_SLOPE_REGRESSION
 	void setSlopeFilterCoefficients(uint8_t b){
+#if !TEMP_SENSOR_SLOPE_REGRESSION
 		slopeFilter.setCoefficients(b);
-	}			
+#endif
+	}
+	
+	// Set the number of cascaded sections of each filter, 1 to CASCADED_FILTER_MAX_SECTIONS
+	void setFastFilterSections(uint8_t count){
+		fastFilter.setSections(count);
+	}
+	
+	void setSlowFilterSections(uint8_t count){
+		slowFilter.setSections(count);
+	}
+	
+	void setSlopeFilterSections(uint8_t count){
+#if !TEMP_SENSOR_SLOPE_REGRESSION
+		slopeFilter.setSections(count);
+#endif
+	}
+	
+	// Set the resolution in bits (9-12). It is written to the device between two conversions.
+	void setResolution(uint8_t bits){
+		targetResolution = constrain(bits, 9, 12);
+	}
+	
+	// resolution of the device, 0 when the sensor is not initialized
+	uint8_t getResolution(void){
+		return resolution;
+	}
+	
+	// max conversion time in milliseconds for the resolution of the device, 0 when the sensor is not initialized
+	uint16_t getConversionTime(void);
+	
+#if TEMP_SENSOR_EVENT_MODE
+	// Only read the device when its temperature has changed by about TEMP_SENSOR_EVENT_WINDOW degrees.
+	// For spare and monitoring probes: the reading only follows the temperature in whole degree steps.
+	void setEventMode(bool enabled){
+		eventMode = enabled;
+		eventReadsLeft = 0; // program the window with the next reading
+	}
+	
+	// number of conversions without a read, because the device stayed in its alarm window
+	uint16_t getSkippedReads(void){
+		return skippedReads;
+	}
+#endif
+	
+#if TEMP_SENSOR_CHECKPOINT
+	// Returns the current filter state. The temperature is INT_MIN when the sensor is not connected.
+	void getCheckpoint(TempSensorCheckpoint & checkpoint);
+	
+	// The filters start from the checkpoint when the sensor connects, if the first reading agrees with it
+	void setRestorePoint(const TempSensorCheckpoint & checkpoint){
+		restorePoint = checkpoint;
+	}
+#endif
+	
+	const TempSensorStats & getStats(void){
+		return stats;
+	}
+	
+	// longest time in microseconds that poll() has kept the main loop busy
+	uint16_t getMaxPollTime(void){
+		return stats.maxReadTime;
+	}
+	
+	// mean time in microseconds of the bus transactions in poll()
+	uint16_t getMeanReadTime(void){
+		return (stats.readCount == 0) ? 0 : stats.totalReadTime / stats.readCount;
+	}
+	
+	uint8_t getRole(void){
+		return role;
+	}
+	
+	uint8_t getPin(void){
+		return pinNr;
+	}
 	
 	private:
+	void requestConversion(void);
+	bool reconnect(void);
+	void retry(void);
+	void backOff(void);
+	bool discover(void);
+	bool applyResolution(void);
+	void startReading(void);
+#if ONEWIRE_TIMER
+	void finishReading(void);
+#else
+	fixed7_9 readTemperature(void);
+#endif
+#if TEMP_SENSOR_FAST_READ
+	bool fastReadDue(void);
+	fixed7_9 checkFastReading(int16_t raw, bool present);
+#endif
+	fixed7_9 checkScratchPad(uint8_t * scratchPad, bool present);
+	void setReading(fixed7_9 temperature);
+	void recordReadTime(unsigned long readTime);
+	void countReadResult(void);
+	void initFilters(fixed7_9 temperature);
+#if TEMP_SENSOR_EVENT_MODE
+	bool inAlarmWindow(void);
+	void setAlarmWindow(void);
+#endif
+#if TEMP_SENSOR_LOCK_STEP
+	static void readLockStep(OneWireLockStep & lockStep, TempSensor * const * group);
+#endif
+	
+	const uint8_t role; // see deviceRoles in DeviceRegistry.h
 	const uint8_t pinNr;
 	bool connected;
-	unsigned long lastRequestTime; // in milliseconds
-	unsigned char updateCounter;
-	fixed7_25 prevOutputForSlope;	
+	uint8_t state;
+	uint8_t debounceCount; // readings to discard before the sensor is connected
+	uint8_t retryInterval; // updates between attempts to find the device
+	uint8_t retryCountdown; // updates until the next attempt
+	uint8_t resolution; // current resolution of the device
+	uint8_t targetResolution; // resolution to write to the device
+	fixed7_9 reading; // unfiltered reading collected by poll()
+	TempSensorStats stats;
+	uint8_t fullReadCounter; // fast reads left until the next full read
+#if TEMP_SENSOR_EVENT_MODE
+	bool eventMode;
+	uint8_t eventReadsLeft; // conversions that can be skipped until the next read, 0 when no window is set
+	uint16_t skippedReads;
+#endif
 	
 	CascadedFilter fastFilter;
-	CascadedFilter slowFilter;
-	CascadedFilter slopeFilter;
+	DecimatingFilter slowFilter;
+#if TEMP_SENSOR_SLOPE_REGRESSION
+	SlopeEstimator slopeEstimator;
+#else
+	DecimatingFilter slopeFilter; // differentiates the output of the slow filter
+#endif
+#if TEMP_SENSOR_CHECKPOINT
+	TempSensorCheckpoint restorePoint; // temperature is INT_MIN when there is nothing to restore
+#endif
 	
+	TempSensorBus * bus;
 	OneWire * oneWire;
 	DallasTemperature * sensor;
 	DeviceAddress sensorAddress;
+	
+#if ONEWIRE_TIMER
+	// There is one timer, so one background read at a time for all sensors
+	static TempSensor * reader; // sensor that started the background read, until it has collected the result
+	static bool readFast; // the background read is a fast read
+	static uint8_t readCommand[10]; // Match ROM, address and Read Scratchpad
+	static uint8_t readBuffer[9];
+#endif
 };
 
 
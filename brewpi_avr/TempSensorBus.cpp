@@ -0,0 +1,99 @@
+/*
+ * Copyright 2012 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ * 
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "TempSensorBus.h"
+#include "TempSensor.h"
+#include "Ticks.h"
+#include <string.h>
+
+void TempSensorBus::addSensor(TempSensor * tempSensor){
+	if(numSensors < MAX_TEMP_SENSORS_PER_BUS){
+		sensors[numSensors++] = tempSensor;
+	}
+}
+
+void TempSensorBus::requestConversion(void){
+	if(converting){
+		return; // sensors that request a conversion now will use the result of the running conversion
+	}
+	// reset, skip ROM and start conversion for all devices on the bus
+	sensor.requestTemperatures();
+	// all devices convert at their own resolution, so wait for the slowest
+	conversionTime = 0;
+	for(uint8_t i=0; i<numSensors; i++){
+		uint16_t sensorTime = sensors[i]->getConversionTime();
+		if(sensorTime > conversionTime){
+			conversionTime = sensorTime;
+		}
+	}
+	if(conversionTime == 0){
+		conversionTime = TEMP_SENSOR_CONVERSION_TIME;
+	}
+	requestTime = ticks.millis();
+	lastPollTime = requestTime;
+	converting = true;
+#if TEMP_SENSOR_EVENT_MODE
+	alarmSearchDone = false;
+#endif
+}
+
+bool TempSensorBus::conversionComplete(void){
+	if(!converting){
+		return true;
+	}
+	unsigned long now = ticks.millis();
+	if(now - requestTime >= conversionTime){
+		converting = false; // max conversion time has passed
+	}
+	else if(now - lastPollTime >= TEMP_SENSOR_POLL_INTERVAL){
+		// Check whether all devices are done, but not on every pass
+		lastPollTime = now;
+		converting = !sensor.isConversionComplete();
+	}
+	return !converting;
+}
+
+#if TEMP_SENSOR_EVENT_MODE
+bool TempSensorBus::hasAlarm(const uint8_t * address){
+	if(!alarmSearchDone){
+		// One search per conversion for all sensors on the bus. When nothing has an alarm, it takes a single reset and command.
+		alarmSearchDone = true;
+		numAlarms = 0;
+		DeviceAddress found;
+		sensor.resetAlarmSearch();
+		while(sensor.alarmSearch(found)){
+			if(numAlarms == MAX_TEMP_SENSORS_PER_BUS){
+				numAlarms = 0xFF; // too many alarms to remember, assume all devices have one
+				break;
+			}
+			memcpy(alarms[numAlarms++], found, sizeof(DeviceAddress));
+		}
+	}
+	if(numAlarms == 0xFF){
+		return true;
+	}
+	for(uint8_t i=0; i<numAlarms; i++){
+		if(memcmp(alarms[i], address, sizeof(DeviceAddress)) == 0){
+			return true;
+		}
+	}
+	return false;
+}
+#endif
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2012 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ * 
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TEMPSENSORBUS_H_
+#define TEMPSENSORBUS_H_
+
+#include "OneWire.h"
+#include "DallasTemperature.h"
+
+// Max conversion time in ms for a 12 bit reading, used when no sensor on the bus is initialized
+#define TEMP_SENSOR_CONVERSION_TIME 750
+// Interval in ms to check the bus for a completed conversion
+#define TEMP_SENSOR_POLL_INTERVAL 10
+// Maximum number of temperature sensors on one pin
+#define MAX_TEMP_SENSORS_PER_BUS 4
+
+// Set to 1 to allow sensors that are only read when their temperature leaves an alarm window, see TempSensor::setEventMode()
+// The alarm search needs REQUIRESALARMS in DallasTemperature.h
+#ifndef TEMP_SENSOR_EVENT_MODE
+#define TEMP_SENSOR_EVENT_MODE REQUIRESALARMS
+#endif
+#if TEMP_SENSOR_EVENT_MODE && !REQUIRESALARMS
+#error "TEMP_SENSOR_EVENT_MODE needs REQUIRESALARMS"
+#endif
+
+class TempSensor;
+
+/* A TempSensorBus manages all temperature sensors on one pin.
+ * All sensors on a pin share the OneWire and DallasTemperature objects. A conversion is started on all
+ * devices at once with a single Skip-ROM request, after which each sensor reads its own scratchpad.
+ * Buses are declared statically, one per pin. Sensors on the same pin are constructed with the same bus and add themselves to it.
+ * The max conversion time of the bus follows the slowest sensor on it, which depends on its resolution.
+ * With TEMP_SENSOR_EVENT_MODE, one alarm search after each conversion finds the devices that left their alarm window.
+ */
+class TempSensorBus{
+	public:
+	TempSensorBus(uint8_t pinNumber) : pinNr(pinNumber), oneWire(pinNumber), sensor(&oneWire){
+		converting = false;
+		numSensors = 0;
+		conversionTime = TEMP_SENSOR_CONVERSION_TIME;
+		requestTime = 0;
+		lastPollTime = 0;
+#if TEMP_SENSOR_EVENT_MODE
+		alarmSearchDone = false;
+		numAlarms = 0;
+#endif
+		sensor.setWaitForConversion(false);
+	}
+	
+	void addSensor(TempSensor * tempSensor);
+	
+	// start a conversion on all devices, unless a conversion is already running.
+	void requestConversion(void);
+	
+	// returns true when the last requested conversion has completed.
+	bool conversionComplete(void);
+	
+#if TEMP_SENSOR_EVENT_MODE
+	// returns true when the device has an alarm after the last conversion. Only call when the conversion is complete.
+	bool hasAlarm(const uint8_t * address);
+#endif
+	
+	uint8_t getPin(void){
+		return pinNr;
+	}
+	
+	OneWire * getOneWire(void){
+		return &oneWire;
+	}
+	
+	DallasTemperature * getSensor(void){
+		return &sensor;
+	}
+	
+	private:
+	const uint8_t pinNr;
+	bool converting;
+	uint16_t conversionTime; // max time in milliseconds for the running conversion
+	unsigned long requestTime; // in milliseconds
+	unsigned long lastPollTime; // in milliseconds
+	
+	OneWire oneWire;
+	DallasTemperature sensor; // constructed after oneWire, which it uses
+	
+	TempSensor * sensors[MAX_TEMP_SENSORS_PER_BUS];
+	uint8_t numSensors;
+	
+#if TEMP_SENSOR_EVENT_MODE
+	bool alarmSearchDone; // the alarm search for the last conversion was done
+	uint8_t numAlarms; // number of devices found by the alarm search, 0xFF when there were more than fit in alarms
+	DeviceAddress alarms[MAX_TEMP_SENSORS_PER_BUS];
+#endif
+};
+
+#endif /* TEMPSENSORBUS_H_ */
@@ -32,5 +32,9 @@ ticks_seconds_t Ticks::timeSince(ticks_seconds_t previousTime){
 	}
 }
 
+#if TICKS_VIRTUAL
+ticks_millis_t Ticks::now = 0;
+#endif
+
 Ticks ticks;
 Delay wait;
\ No newline at end of file
@@ -28,6 +28,13 @@ typedef unsigned long ticks_micros_t;
 typedef uint16_t ticks_seconds_t;
 typedef uint8_t ticks_seconds_tiny_t;
 
+// Set to 1 to use a virtual clock that only moves when it is advanced, for simulations that run
+// faster than real time. See test/sim/ControlSimulation.h.
+#ifndef TICKS_VIRTUAL
+#define TICKS_VIRTUAL 0
+#endif
+
+#if !TICKS_VIRTUAL
 /*
  * The Ticks class provides the time period since the device was powered up.
  */
@@ -46,6 +53,29 @@ public:
 	static void millis(uint32_t millis)	{ ::delay(millis); }
 	
 };
+#else
+/*
+ * Virtual time since the start of the simulation. Waiting advances the time immediately.
+ */
+class Ticks {
+public:
+	ticks_millis_t millis() { return now; }
+	ticks_micros_t micros() { return now*1000; }
+	ticks_seconds_t seconds() { return now/1000; }
+	static ticks_seconds_t timeSince(ticks_seconds_t timeStamp);
+	static void advance(ticks_millis_t millis) { now += millis; }
+private:
+	static ticks_millis_t now;
+};
+
+
+class Delay {
+public:
+	static void seconds(uint16_t seconds)	{ Ticks::advance(seconds*1000ul); }
+	static void millis(uint32_t millis)	{ Ticks::advance(millis); }
+	
+};
+#endif
 
 extern Delay wait;
 extern Ticks ticks;
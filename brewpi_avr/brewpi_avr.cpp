@@ -34,6 +34,7 @@
 #include "pins.h"
 #include "RotaryEncoder.h"
 #include "Buzzer.h"
+#include "SensorCheckpoint.h"
 
 // global class objects static and defined in class cpp and h files
 
@@ -61,6 +62,9 @@ void setup()
 	
 	tempControl.loadSettingsAndConstants(); //read previous settings from EEPROM
 	tempControl.init();
+#if TEMP_SENSOR_CHECKPOINT
+	sensorCheckpoint.restore(); // warm start the filters when the sensors connect
+#endif
 	tempControl.updatePID();
 	tempControl.updateState();
 	
@@ -102,19 +106,28 @@ void loop(void)
 		lastUpdate=ticks.millis();
 		
 		tempControl.updateTemperatures();		
+#if TEMP_SENSOR_CHECKPOINT
+		sensorCheckpoint.update();
+#endif
 		tempControl.detectPeaks();
 		tempControl.updatePID();
 		tempControl.updateState();
 		tempControl.updateOutputs();
-		if(rotaryEncoder.pushed()){
-			rotaryEncoder.resetPushed();
-			menu.pickSettingToChange();	
+		if(!menu.isActive()){
+			// the menu blinks these fields, don't redraw them while it is open
+			display.printState();
+			display.printAllTemperatures();
+			display.printMode();
 		}
-		display.printState();
-		display.printAllTemperatures();
-		display.printMode();
 		display.lcd.updateBacklight();
-	}	
+	}
+	tempControl.pollSensors();
+	// the menu is advanced one step per pass, so it never blocks temperature control
+	if(rotaryEncoder.pushed() && !menu.isActive()){
+		rotaryEncoder.resetPushed();
+		menu.open();
+	}
+	menu.update();
 	//listen for incoming serial connections while waiting top update
 	piLink.receive();
 }
@@ -51,6 +51,13 @@ static const char JSONKEY_fridgeSlopeFilter[] PROGMEM = "fridgeSlopeFilt";
 static const char JSONKEY_beerFastFilter[] PROGMEM = "beerFastFilt";
 static const char JSONKEY_beerSlowFilter[] PROGMEM = "beerSlowFilt";
 static const char JSONKEY_beerSlopeFilter[] PROGMEM = "beerSlopeFilt";
+static const char JSONKEY_fridgeFastSections[] PROGMEM = "fridgeFastSect";
+static const char JSONKEY_fridgeSlowSections[] PROGMEM = "fridgeSlowSect";
+static const char JSONKEY_fridgeSlopeSections[] PROGMEM = "fridgeSlopeSect";
+static const char JSONKEY_beerFastSections[] PROGMEM = "beerFastSect";
+static const char JSONKEY_beerSlowSections[] PROGMEM = "beerSlowSect";
+static const char JSONKEY_beerSlopeSections[] PROGMEM = "beerSlopeSect";
+static const char JSONKEY_pidInput[] PROGMEM = "pidInput";
 
 // variable;
 static const char JSONKEY_beerDiff[] PROGMEM = "beerDiff";
@@ -64,5 +71,24 @@ static const char JSONKEY_negPeakEstimate[] PROGMEM = "negPeakEst"; // last neg
 static const char JSONKEY_posPeakEstimate[] PROGMEM = "posPeakEst";
 static const char JSONKEY_negPeak[] PROGMEM = "negPeak"; // last true neg peak
 static const char JSONKEY_posPeak[] PROGMEM = "posPeak";
+static const char JSONKEY_kalmanTemp[] PROGMEM = "kalmanTemp"; // beer temperature estimate
+static const char JSONKEY_kalmanSlope[] PROGMEM = "kalmanSlope";
+static const char JSONKEY_beerPollTime[] PROGMEM = "beerPollMax"; // max time in us spent collecting a sensor reading in one loop pass
+static const char JSONKEY_fridgePollTime[] PROGMEM = "fridgePollMax";
+
+// sensor health, one object per sensor
+static const char JSONKEY_sensorRole[] PROGMEM = "role"; // see deviceRoles in DeviceRegistry.h
+static const char JSONKEY_sensorPin[] PROGMEM = "pin";
+static const char JSONKEY_sensorConnected[] PROGMEM = "connected";
+static const char JSONKEY_sensorResolution[] PROGMEM = "res";
+static const char JSONKEY_fastReads[] PROGMEM = "fastReads";
+static const char JSONKEY_fullReads[] PROGMEM = "fullReads";
+static const char JSONKEY_rejectedReads[] PROGMEM = "rejected";
+static const char JSONKEY_crcErrors[] PROGMEM = "crcErr";
+static const char JSONKEY_presenceErrors[] PROGMEM = "presenceErr";
+static const char JSONKEY_disconnects[] PROGMEM = "disconnects";
+static const char JSONKEY_reconnects[] PROGMEM = "reconnects";
+static const char JSONKEY_maxReadTime[] PROGMEM = "readMax"; // in us
+static const char JSONKEY_meanReadTime[] PROGMEM = "readMean";
 
 #endif /* JSON_H_ */
\ No newline at end of file
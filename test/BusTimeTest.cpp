@@ -0,0 +1,100 @@
+/*
+ * Measures the bus time per control tick for N sensors on one pin, counted by the simulated bus of OneWireSim.h.
+ * The old path requests a conversion for each sensor (reset, skip, STARTCONVO) and then reads its scratchpad.
+ * TempSensorBus requests one conversion for all sensors, after which each sensor reads its scratchpad: 9 bytes with
+ * CRC for a full read, or only the 2 temperature bytes for a fast read, see TempSensor::readTemperature().
+ */
+
+#include "OneWire.h"
+#include "OneWireSim.h"
+#include "DallasTemperature.h"
+#include "Ticks.h"
+#include "HostTest.h"
+#include <stdio.h>
+
+#define BUS_PIN 4
+#define MAX_SENSORS 8
+
+static OneWireSimDevice * devices[MAX_SENSORS];
+
+enum readPath{
+	PATH_OLD,
+	PATH_SHARED,
+	PATH_SHARED_FAST,
+};
+
+// bus time in microseconds of one tick: the conversion request(s) and a reading of each sensor.
+// The wait for the conversion takes no bus time.
+static unsigned long tick(DallasTemperature & sensors, uint8_t count, readPath path){
+	OneWireSimBus * bus = OneWireSimBus::forPin(BUS_PIN);
+	bus->clearStatistics();
+	for(uint8_t i = 0; i < (path == PATH_OLD ? count : 1); i++){
+		sensors.requestTemperatures();
+	}
+	Ticks::advance(750);
+	for(uint8_t i = 0; i < count; i++){
+		uint8_t * address = (uint8_t *) devices[i]->getAddress();
+		if(path == PATH_SHARED_FAST){
+			CHECK(sensors.getTempRawFast(address) == 20 << 4);
+		}
+		else{
+			CHECK(sensors.getTempFixed(address) == 20 << 9);
+		}
+	}
+	return bus->busTime;
+}
+
+int main(void){
+	OneWireSimBus * bus = OneWireSimBus::forPin(BUS_PIN);
+	for(uint8_t i = 0; i < MAX_SENSORS; i++){
+		devices[i] = new OneWireSimDevice(DS18B20MODEL, 0x100 + i);
+		devices[i]->setTemperature(20 << 4);
+	}
+	OneWire oneWire(BUS_PIN);
+	DallasTemperature sensors(&oneWire);
+	
+	// The transactions the paths are made of. The time of a write slot depends on the bit, so selecting a
+	// device takes a slightly different time for each ROM code.
+	bus->clearStatistics();
+	sensors.requestTemperatures();
+	unsigned long request = bus->busTime;
+	Ticks::advance(750);
+	unsigned long fullRead[MAX_SENSORS];
+	unsigned long fastRead[MAX_SENSORS];
+	for(uint8_t i = 0; i < MAX_SENSORS; i++){
+		bus->attach(devices[i]);
+		bus->clearStatistics();
+		sensors.getTempFixed((uint8_t *) devices[i]->getAddress());
+		fullRead[i] = bus->busTime;
+		bus->clearStatistics();
+		sensors.getTempRawFast((uint8_t *) devices[i]->getAddress());
+		fastRead[i] = bus->busTime;
+		bus->detach(devices[i]);
+	}
+	printf("request %.2f ms, full read %.2f ms, fast read %.2f ms\n", request / 1000.0, fullRead[0] / 1000.0, fastRead[0] / 1000.0);
+	
+	printf(" N   old: N x (request + read)   shared request   shared request, fast reads\n");
+	for(uint8_t count = 2; count <= MAX_SENSORS; count *= 2){
+		unsigned long fullReads = 0;
+		unsigned long fastReads = 0;
+		for(uint8_t i = 0; i < count; i++){
+			bus->attach(devices[i]);
+			fullReads += fullRead[i];
+			fastReads += fastRead[i];
+		}
+		unsigned long oldPath = tick(sensors, count, PATH_OLD);
+		unsigned long shared = tick(sensors, count, PATH_SHARED);
+		unsigned long sharedFast = tick(sensors, count, PATH_SHARED_FAST);
+		printf("%2u   %7.2f ms %20.2f ms %13.2f ms\n", count, oldPath / 1000.0, shared / 1000.0, sharedFast / 1000.0);
+		
+		// each sensor saves one request, the readings take the same time
+		CHECK(oldPath == count * request + fullReads);
+		CHECK(shared == request + fullReads);
+		CHECK(sharedFast == request + fastReads);
+		CHECK(oldPath - shared == (count - 1) * request);
+		for(uint8_t i = 0; i < count; i++){
+			bus->detach(devices[i]);
+		}
+	}
+	return hostTestResult("BusTimeTest");
+}
@@ -0,0 +1,112 @@
+/*
+ * Checks OneWire::crc8 against a bitwise reference and reports its speed on the host.
+ * The program is built once for each ONEWIRE_CRC8_TABLE variant.
+ */
+
+#include "OneWire.h"
+#include "HostTest.h"
+#include <stdlib.h>
+#include <time.h>
+
+// Dallas/Maxim CRC8, polynomial x^8 + x^5 + x^4 + 1, one bit at a time
+static uint8_t referenceCrc8(const uint8_t * data, uint8_t length){
+	uint8_t crc = 0;
+	while(length--){
+		uint8_t byte = *data++;
+		for(uint8_t bit = 0; bit < 8; bit++){
+			uint8_t mix = (crc ^ byte) & 0x01;
+			crc >>= 1;
+			if(mix){
+				crc ^= 0x8C;
+			}
+			byte >>= 1;
+		}
+	}
+	return crc;
+}
+
+// Every (crc, byte) pair occurs in the two byte inputs, because the CRC of the first byte takes all 256 values.
+// Equal results for all of them mean equal results for inputs of any length.
+static void checkAllTransitions(void){
+	uint8_t data[2];
+	unsigned long mismatches = 0;
+	for(unsigned int first = 0; first < 256; first++){
+		for(unsigned int second = 0; second < 256; second++){
+			data[0] = first;
+			data[1] = second;
+			if(OneWire::crc8(data, 2) != referenceCrc8(data, 2)){
+				mismatches++;
+			}
+		}
+	}
+	CHECK(mismatches == 0);
+}
+
+// A DS18B20 scratchpad: temperature, TH, TL, configuration, 3 reserved bytes and the CRC
+static void makeScratchPad(uint8_t * scratchPad, uint16_t temperature, uint8_t th, uint8_t tl, uint8_t config, uint8_t reserved){
+	scratchPad[0] = temperature & 0xFF;
+	scratchPad[1] = temperature >> 8;
+	scratchPad[2] = th;
+	scratchPad[3] = tl;
+	scratchPad[4] = config;
+	scratchPad[5] = 0xFF;
+	scratchPad[6] = reserved;
+	scratchPad[7] = 0x10;
+	scratchPad[8] = referenceCrc8(scratchPad, 8);
+}
+
+// The CRC of a valid scratchpad matches byte 8, and the CRC over all 9 bytes is 0. A flipped bit is detected.
+static unsigned long checkScratchPad(uint8_t * scratchPad){
+	unsigned long errors = 0;
+	if(OneWire::crc8(scratchPad, 8) != scratchPad[8] || OneWire::crc8(scratchPad, 9) != 0){
+		errors++;
+	}
+	uint8_t bit = rand() % 72;
+	scratchPad[bit >> 3] ^= 1 << (bit & 7);
+	if(OneWire::crc8(scratchPad, 9) == 0){
+		errors++;
+	}
+	return errors;
+}
+
+static void checkScratchPads(void){
+	static const uint8_t configs[4] = {0x1F, 0x3F, 0x5F, 0x7F}; // 9 to 12 bits
+	uint8_t scratchPad[9];
+	unsigned long errors = 0;
+	// all temperature words at all resolutions, with the power-on alarm values
+	for(unsigned long temperature = 0; temperature < 0x10000; temperature++){
+		for(uint8_t c = 0; c < 4; c++){
+			makeScratchPad(scratchPad, temperature, 0x4B, 0x46, configs[c], 0x0C);
+			errors += checkScratchPad(scratchPad);
+		}
+	}
+	// random alarm values and reserved bytes
+	for(unsigned long i = 0; i < 1000000; i++){
+		makeScratchPad(scratchPad, rand(), rand(), rand(), configs[rand() & 3], rand());
+		errors += checkScratchPad(scratchPad);
+	}
+	CHECK(errors == 0);
+}
+
+static void benchmark(void){
+	uint8_t data[9] = {0x50, 0x05, 0x4B, 0x46, 0x7F, 0xFF, 0x0C, 0x10, 0x1C};
+	const unsigned long rounds = 10000000;
+	volatile uint8_t sink = 0;
+	clock_t start = clock();
+	for(unsigned long i = 0; i < rounds; i++){
+		data[0] = i;
+		sink ^= OneWire::crc8(data, 9);
+	}
+	double seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+	printf("ONEWIRE_CRC8_TABLE %d: %.2f ns per byte on this host\n", ONEWIRE_CRC8_TABLE, seconds * 1e9 / (rounds * 9));
+}
+
+int main(void){
+	srand(1);
+	checkAllTransitions();
+	checkScratchPads();
+	benchmark();
+	char name[32];
+	snprintf(name, sizeof(name), "Crc8Test (variant %d)", ONEWIRE_CRC8_TABLE);
+	return hostTestResult(name);
+}
@@ -0,0 +1,91 @@
+/*
+ * Injects read errors on the simulated bus and checks that no reading a sensor accepts is further from the
+ * temperature of the device than the plausible window of its fast reads, see TempSensor::checkFastReading().
+ * Errors in the 2 bytes of a fast read are only caught by this window, errors in a full read by the CRC.
+ */
+
+#include "OneWire.h"
+#include "OneWireSim.h"
+#include "TempSensor.h"
+#include "Ticks.h"
+#include "HostTest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define SENSOR_PIN 9
+#define READ_ERROR_RATE 200 // chance per bit in 65536
+
+static TempSensorBus sensorBus(SENSOR_PIN);
+static TempSensor tempSensor(DEVICE_ROLE_FRIDGE, sensorBus);
+static OneWireSimDevice probe(DS18B20MODEL, 0x090807);
+
+// one second of the main loop
+static void second(void){
+	for(uint8_t i = 0; i < 20; i++){
+		Ticks::advance(50);
+		tempSensor.poll();
+	}
+	tempSensor.update();
+}
+
+// Runs for an hour at a resolution, with a temperature that swings 4 degrees in a few minutes like the air in the
+// fridge. Returns the max error of the accepted readings.
+static long run(uint8_t bits){
+	tempSensor.setResolution(bits);
+	long step = 1L << (17 - bits); // one step of the resolution in fixed7_9
+	long window = max(TEMP_SENSOR_PLAUSIBLE_WINDOW, TEMP_SENSOR_PLAUSIBLE_STEPS * step);
+	OneWireSimBus * bus = OneWireSimBus::forPin(SENSOR_PIN);
+	long maxError = 0;
+	uint16_t wrongReadings = 0;
+	uint16_t readings = 0;
+	TempSensorStats before = tempSensor.getStats();
+	bus->clearStatistics();
+	bus->setErrorRates(0, 0, READ_ERROR_RATE);
+	for(uint16_t t = 0; t < 3600; t++){
+		int16_t temperature = 10*16 + (int16_t) (32 * sin(t / 60.0));
+		probe.setTemperature(temperature);
+		const TempSensorStats & stats = tempSensor.getStats();
+		uint16_t count = stats.fastReads + stats.fullReads - stats.crcErrors - stats.presenceErrors;
+		second();
+		if(!tempSensor.isConnected() || stats.fastReads + stats.fullReads - stats.crcErrors - stats.presenceErrors == count){
+			continue; // no new reading this second
+		}
+		readings++;
+		// the device clears the bits below the resolution
+		long expected = (long) (temperature & ~((1 << (12 - bits)) - 1)) << 5;
+		long error = labs(tempSensor.read() - expected);
+		if(error > maxError){
+			maxError = error;
+		}
+		if(error != 0){
+			wrongReadings++;
+		}
+	}
+	bus->setErrorRates(0, 0, 0);
+	printf("%2u bit: %lu errors injected, %u rejected fast reads, %u CRC errors. %u of %u readings wrong, max error"
+		" %.3f degree, window %.3f degree\n", bits, bus->injectedErrors, tempSensor.getStats().rejectedReads - before.rejectedReads,
+		tempSensor.getStats().crcErrors - before.crcErrors, wrongReadings, readings, maxError / 512.0, window / 512.0);
+	CHECK(readings > 2000); // a CRC error disconnects the sensor until it is debounced again
+	CHECK(bus->injectedErrors > 0);
+	CHECK(maxError <= window);
+	CHECK(window <= max(1L << 7, 2 * step)); // 0.25 degree, or 2 steps at a coarse resolution
+	return maxError;
+}
+
+int main(void){
+	srand(9);
+	deviceRegistry.clear();
+	OneWireSimBus::forPin(SENSOR_PIN)->attach(&probe);
+	probe.setTemperature(10*16);
+	tempSensor.init();
+	for(uint8_t i = 0; i < 10; i++){
+		second();
+	}
+	CHECK(tempSensor.isConnected());
+	
+	run(TEMP_SENSOR_RESOLUTION_FULL);
+	run(TEMP_SENSOR_RESOLUTION_FAST);
+	
+	return hostTestResult("FastReadTest");
+}
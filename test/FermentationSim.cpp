@@ -0,0 +1,42 @@
+/*
+ * Simulates a two week fermentation with the real temperature control, see sim/ControlSimulation.h, and prints
+ * the summary. Usage: FermentationSim [csv file]
+ * With a file name, the temperatures, settings and outputs are written to it once per simulated minute.
+ */
+
+#include "ControlSimulation.h"
+#include "TempControl.h"
+#include <stdio.h>
+#include <time.h>
+
+#define SIMULATION_DAYS 14
+
+int main(int argc, char * argv[]){
+	FILE * csvFile = 0;
+	if(argc > 1){
+		csvFile = fopen(argv[1], "w");
+		if(csvFile == 0){
+			fprintf(stderr, "can't open %s\n", argv[1]);
+			return 1;
+		}
+	}
+	
+	ThermalSim plant;
+	plant.init(20);
+	plant.setAmbient(20);
+	plant.setFermentation(15, 2*86400L, 86400L); // 15W at day 2
+	ControlSimulation simulation(plant);
+	simulation.init();
+	tempControl.setBeerTemp(18<<9);
+	
+	clock_t start = clock();
+	simulation.run(SIMULATION_DAYS*86400L, csvFile, 60);
+	double runTime = (double) (clock() - start) / CLOCKS_PER_SEC;
+	
+	simulation.printSummary(stdout);
+	printf("run time:          %.1f s\n", runTime);
+	if(csvFile != 0){
+		fclose(csvFile);
+	}
+	return 0;
+}
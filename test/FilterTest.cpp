@@ -0,0 +1,90 @@
+/*
+ * Checks that CascadedFilter gives bit-identical results to the reference filter in ReferenceFilter.h,
+ * for 1 to 4 sections and b values that use the specialized steps (0-6) and the run-time shifts (7, 8).
+ */
+
+#include "CascadedFilter.h"
+#include "ReferenceFilter.h"
+#include "HostTest.h"
+#include <stdlib.h>
+
+#define SAMPLES 200000
+
+enum signals{
+	SIGNAL_NOISE, // any 16 bit value
+	SIGNAL_STEPS, // large steps every 2000 samples
+	SIGNAL_ROOM, // small noise around 20 degrees, as from a sensor
+	NUM_SIGNALS
+};
+
+static fixed7_9 sample(uint8_t signal, unsigned long i){
+	switch(signal){
+		case SIGNAL_NOISE:
+			return (fixed7_9) (rand() & 0xFFFF);
+		case SIGNAL_STEPS:
+			return ((i / 2000) & 1) ? 100*512 : -50*512;
+		default:
+			return 20*512 + (rand() % 65) - 32;
+	}
+}
+
+static unsigned long mismatches = 0;
+static unsigned long comparisons = 0;
+
+static void compare(bool equal){
+	comparisons++;
+	if(!equal){
+		mismatches++;
+	}
+}
+
+static void compareFilters(uint8_t sections, uint8_t b, uint8_t signal){
+	CascadedFilter filter;
+	ReferenceCascadedFilter reference(sections);
+	filter.setSections(sections);
+	filter.setCoefficients(b);
+	reference.setCoefficients(b);
+	fixed7_9 start = sample(signal, 0);
+	filter.init(start);
+	reference.init(start);
+	
+	for(unsigned long i = 1; i < SAMPLES; i++){
+		fixed7_9 val = sample(signal, i);
+		if(i % 50000 == 0){
+			// start again from a new value
+			filter.init(val);
+			reference.init(val);
+			continue;
+		}
+		if(i & 1){
+			compare(filter.add(val) == reference.add(val));
+		}
+		else{
+			fixed7_25 doublePrecision = (((fixed7_25) val) << 16) | (rand() & 0xFFFF);
+			compare(filter.addDoublePrecision(doublePrecision) == reference.addDoublePrecision(doublePrecision));
+		}
+		compare(filter.readInput() == reference.readInput());
+		compare(filter.readOutput() == reference.readOutput());
+		compare(filter.readOutputDoublePrecision() == reference.readOutputDoublePrecision());
+		compare(filter.readPrevOutputDoublePrecision() == reference.readPrevOutputDoublePrecision());
+		compare(filter.detectPosPeak() == reference.detectPosPeak());
+		compare(filter.detectNegPeak() == reference.detectNegPeak());
+	}
+}
+
+int main(void){
+	srand(1);
+	for(uint8_t sections = 1; sections <= CASCADED_FILTER_MAX_SECTIONS; sections++){
+		for(uint8_t b = 0; b <= 8; b++){
+			for(uint8_t signal = 0; signal < NUM_SIGNALS; signal++){
+				unsigned long before = mismatches;
+				compareFilters(sections, b, signal);
+				if(!CHECK(mismatches == before)){
+					printf("sections %u, b %u, signal %u: %lu mismatches\n", sections, b, signal, mismatches - before);
+				}
+			}
+		}
+	}
+	printf("%lu comparisons, %lu mismatches\n", comparisons, mismatches);
+	return hostTestResult("FilterTest");
+}
@@ -0,0 +1,63 @@
+/*
+ * Compares the fixed point temperature of DallasTemperature::getTempFixed() with the float temperature of getTempC()
+ * for every raw value in the range of the device (-55 to 125 degrees), for the DS18B20 at each resolution and for
+ * the DS18S20 with its extended resolution from COUNT_REMAIN. Built with REQUIRESFLOAT, see the Makefile.
+ */
+
+#include "OneWire.h"
+#include "OneWireSim.h"
+#include "DallasTemperature.h"
+#include "Ticks.h"
+#include "HostTest.h"
+#include <stdio.h>
+
+#define BUS_PIN 5
+
+#define RAW_MIN (-55*16)
+#define RAW_MAX (125*16)
+
+static OneWireSimDevice ds18b20(DS18B20MODEL, 0x010203);
+static OneWireSimDevice ds18s20(DS18S20MODEL, 0x040506);
+
+// Returns the number of raw values for which the fixed point and float temperature differ
+static uint16_t compare(DallasTemperature & sensors, OneWireSimDevice & device){
+	uint8_t * address = (uint8_t *) device.getAddress();
+	uint16_t differences = 0;
+	for(int16_t raw = RAW_MIN; raw <= RAW_MAX; raw++){
+		device.setTemperature(raw);
+		sensors.requestTemperaturesByAddress(address);
+		Ticks::advance(750);
+		long fixed = sensors.getTempFixed(address);
+		float celsius = sensors.getTempC(address);
+		// the resolution of both is 1/16 degree or coarser, so the float is exact in fixed7_9
+		long expected = constrain((long) (celsius * 512), -32767, 32767);
+		if(fixed != expected){
+			if(differences == 0){
+				printf("raw %d: fixed %ld, float %f\n", raw, fixed, celsius);
+			}
+			differences++;
+		}
+	}
+	return differences;
+}
+
+int main(void){
+	OneWireSimBus * bus = OneWireSimBus::forPin(BUS_PIN);
+	bus->attach(&ds18b20);
+	bus->attach(&ds18s20);
+	OneWire oneWire(BUS_PIN);
+	DallasTemperature sensors(&oneWire);
+	sensors.begin();
+	
+	for(uint8_t bits = 9; bits <= 12; bits++){
+		CHECK(sensors.setResolution((uint8_t *) ds18b20.getAddress(), bits, false));
+		printf("DS18B20 %2u bit: ", bits);
+		CHECK(compare(sensors, ds18b20) == 0);
+		printf("compared\n");
+	}
+	printf("DS18S20:        ");
+	CHECK(compare(sensors, ds18s20) == 0);
+	printf("compared\n");
+	
+	return hostTestResult("FixedTemperatureTest");
+}
@@ -0,0 +1,36 @@
+/*
+ * Checks for the host tests. A test program returns hostTestResult() from main(),
+ * which is non-zero when a check failed.
+ */
+
+#ifndef HOST_TEST_H_
+#define HOST_TEST_H_
+
+#include <stdio.h>
+
+static unsigned long hostTestChecks = 0;
+static unsigned long hostTestFailures = 0;
+
+#define CHECK(condition) hostTestCheck((condition), #condition, __FILE__, __LINE__)
+
+static inline bool hostTestCheck(bool passed, const char * condition, const char * file, int line){
+	hostTestChecks++;
+	if(!passed){
+		hostTestFailures++;
+		if(hostTestFailures <= 10){
+			printf("%s:%d: check failed: %s\n", file, line, condition);
+		}
+	}
+	return passed;
+}
+
+static inline int hostTestResult(const char * name){
+	if(hostTestFailures){
+		printf("%s: %lu of %lu checks FAILED\n", name, hostTestFailures, hostTestChecks);
+		return 1;
+	}
+	printf("%s: %lu checks passed\n", name, hostTestChecks);
+	return 0;
+}
+
+#endif /* HOST_TEST_H_ */
@@ -0,0 +1,194 @@
+/*
+ * Replays a simulated fridge (ThermalSim) through the KalmanEstimator and through the beer filters of TempSensor
+ * (slow filter and slope filter), and prints the lag, the error and the noise of both.
+ * The readings have 0.02 degree of noise and are rounded to 1/16 degree, like a DS18B20 at 12 bits.
+ * There is no recorded data in the repository, pass a file with one beer and one fridge temperature in degrees per
+ * line, one line per second, to replay it instead. A recording has no true value, so only the differences between
+ * the estimates are printed for it.
+ */
+
+#include "KalmanEstimator.h"
+#include "ThermalSim.h"
+#include "SensorFilterChain.h"
+#include "HostTest.h"
+#include <stdio.h>
+
+#define REPLAY_SECONDS (12*3600L)
+#define MAX_LAG 3600
+#define SENSOR_NOISE 0.02
+
+struct Replay{
+	double trueTemperature[REPLAY_SECONDS];
+	double trueSlope[REPLAY_SECONDS]; // degrees per hour
+	double kalmanTemperature[REPLAY_SECONDS];
+	double kalmanSlope[REPLAY_SECONDS];
+	double filterTemperature[REPLAY_SECONDS];
+	double filterSlope[REPLAY_SECONDS];
+};
+
+static Replay replay;
+
+// Compressor and heater schedule of the replay: 2 hours cooling from hour 1, 1 hour heating from hour 6
+static void outputs(long t, bool & cooling, bool & heating){
+	cooling = t >= 3600 && t < 3*3600;
+	heating = t >= 6*3600 && t < 7*3600;
+}
+
+static void run(double beerToAir){
+	ThermalSim plant;
+	plant.params.beerToAir = beerToAir;
+	plant.init(20);
+	plant.setAmbient(20);
+	KalmanEstimator kalman;
+	SensorFilterChain filters;
+	filters.init(sensorReading(20));
+	for(long t = 0; t < REPLAY_SECONDS; t++){
+		bool cooling, heating;
+		outputs(t, cooling, heating);
+		double before = plant.getBeer();
+		plant.step(1, cooling, heating);
+		replay.trueTemperature[t] = plant.getBeer();
+		replay.trueSlope[t] = (plant.getBeer() - before) * 3600;
+		
+		fixed7_9 beer = sensorReading(plant.getBeer() + SENSOR_NOISE * gaussianNoise());
+		fixed7_9 fridge = sensorReading(plant.getFridge() + SENSOR_NOISE * gaussianNoise());
+		kalman.add(beer, fridge);
+		filters.add(beer);
+		replay.kalmanTemperature[t] = toDegrees(kalman.readTemperature());
+		replay.kalmanSlope[t] = toDegrees(kalman.readSlope());
+		replay.filterTemperature[t] = filters.temperature();
+		replay.filterSlope[t] = filters.filterSlope();
+	}
+}
+
+// rms difference between the estimate and the true value of lag seconds earlier, after the first hour
+static double rmsError(const double * estimate, const double * truth, long lag){
+	double squares = 0;
+	long count = 0;
+	for(long t = 3600; t < REPLAY_SECONDS; t++){
+		double error = estimate[t] - truth[t - lag];
+		squares += error * error;
+		count++;
+	}
+	return sqrt(squares / count);
+}
+
+// the delay that fits the estimate best to the true value
+static long lag(const double * estimate, const double * truth){
+	long best = 0;
+	for(long d = 10; d <= MAX_LAG; d += 10){
+		if(rmsError(estimate, truth, d) < rmsError(estimate, truth, best)){
+			best = d;
+		}
+	}
+	return best;
+}
+
+struct Result{
+	double temperatureError;
+	double slopeError;
+	long temperatureLag;
+	long slopeLag;
+};
+
+static void report(const char * name, const double * temperature, const double * slope, Result & result){
+	result.temperatureError = rmsError(temperature, replay.trueTemperature, 0);
+	result.slopeError = rmsError(slope, replay.trueSlope, 0);
+	result.temperatureLag = lag(temperature, replay.trueTemperature);
+	result.slopeLag = lag(slope, replay.trueSlope);
+	printf("  %-7s temperature: rms error %.3f deg, lag %4ld s. Slope: rms error %.3f deg/h, lag %4ld s\n",
+		name, result.temperatureError, result.temperatureLag, result.slopeError, result.slopeLag);
+}
+
+static void compare(double beerToAir, const char * description){
+	run(beerToAir);
+	printf("fridge steps, %s:\n", description);
+	Result kalman, filters;
+	report("kalman", replay.kalmanTemperature, replay.kalmanSlope, kalman);
+	report("filters", replay.filterTemperature, replay.filterSlope, filters);
+	CHECK(kalman.temperatureError < filters.temperatureError);
+	CHECK(kalman.slopeError < filters.slopeError);
+	CHECK(kalman.slopeLag < filters.slopeLag);
+}
+
+// standard deviation of the estimates at a constant temperature
+static void noise(void){
+	KalmanEstimator kalman;
+	SensorFilterChain filters;
+	filters.init(sensorReading(20));
+	double sums[4] = {0};
+	double squares[4] = {0};
+	long count = 0;
+	for(long t = 0; t < REPLAY_SECONDS; t++){
+		fixed7_9 beer = sensorReading(20.03 + SENSOR_NOISE * gaussianNoise());
+		fixed7_9 fridge = sensorReading(20.03 + SENSOR_NOISE * gaussianNoise());
+		kalman.add(beer, fridge);
+		filters.add(beer);
+		if(t < 3600){
+			continue;
+		}
+		double values[4] = {toDegrees(kalman.readTemperature()), toDegrees(kalman.readSlope()),
+			filters.temperature(), filters.filterSlope()};
+		for(uint8_t i = 0; i < 4; i++){
+			sums[i] += values[i];
+			squares[i] += values[i] * values[i];
+		}
+		count++;
+	}
+	double deviation[4];
+	for(uint8_t i = 0; i < 4; i++){
+		double mean = sums[i] / count;
+		deviation[i] = sqrt(squares[i] / count - mean * mean);
+	}
+	printf("constant temperature, noise %.2f deg:\n", SENSOR_NOISE);
+	printf("  kalman  temperature: std %.4f deg. Slope: std %.3f deg/h\n", deviation[0], deviation[1]);
+	printf("  filters temperature: std %.4f deg. Slope: std %.3f deg/h\n", deviation[2], deviation[3]);
+	CHECK(deviation[0] < 0.01);
+	CHECK(deviation[1] < 0.2);
+}
+
+static void recorded(const char * fileName){
+	FILE * file = fopen(fileName, "r");
+	if(!CHECK(file != 0)){
+		return;
+	}
+	KalmanEstimator kalman;
+	SensorFilterChain filters;
+	double beer, fridge;
+	long count = 0;
+	double temperatureSquares = 0;
+	double slopeSquares = 0;
+	while(fscanf(file, "%lf %lf", &beer, &fridge) == 2){
+		if(count++ == 0){
+			filters.init(sensorReading(beer));
+		}
+		else{
+			filters.add(sensorReading(beer));
+		}
+		kalman.add(sensorReading(beer), sensorReading(fridge));
+		double temperatureDifference = toDegrees(kalman.readTemperature()) - filters.temperature();
+		double slopeDifference = toDegrees(kalman.readSlope()) - filters.filterSlope();
+		temperatureSquares += temperatureDifference * temperatureDifference;
+		slopeSquares += slopeDifference * slopeDifference;
+	}
+	fclose(file);
+	if(count > 0){
+		printf("%s, %ld samples: rms difference kalman - filters %.3f deg, %.3f deg/h\n",
+			fileName, count, sqrt(temperatureSquares / count), sqrt(slopeSquares / count));
+	}
+}
+
+int main(int argc, char ** argv){
+	srand(1);
+	if(argc > 1){
+		for(int i = 1; i < argc; i++){
+			recorded(argv[i]);
+		}
+		return hostTestResult("KalmanEstimatorTest");
+	}
+	compare(5, "time constant as in the model");
+	compare(10, "real time constant half of the model");
+	compare(2.5, "real time constant double the model");
+	noise();
+	return hostTestResult("KalmanEstimatorTest");
+}
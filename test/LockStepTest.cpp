@@ -0,0 +1,109 @@
+/*
+ * Compares the beer and fridge sensors, which TempControl::pollSensors() reads in lock-step on A5 and A4, with two
+ * sensors on other pins that are polled one by one. Their devices follow the same temperatures, so every reading must
+ * be the same. A DS18S20 in the lock-step group forces full reads for the whole group.
+ */
+
+#include "OneWire.h"
+#include "OneWireSim.h"
+#include "TempSensor.h"
+#include "TempControl.h"
+#include "Ticks.h"
+#include "HostTest.h"
+#include <stdio.h>
+#include <math.h>
+
+#define REFERENCE_BEER_PIN 6
+#define REFERENCE_FRIDGE_PIN 7
+
+static TempSensorBus referenceBeerBus(REFERENCE_BEER_PIN);
+static TempSensorBus referenceFridgeBus(REFERENCE_FRIDGE_PIN);
+static TempSensor referenceBeer(DEVICE_ROLE_BEER, referenceBeerBus);
+static TempSensor referenceFridge(DEVICE_ROLE_FRIDGE, referenceFridgeBus);
+
+// one second of the main loop
+static void second(void){
+	for(uint8_t i = 0; i < 20; i++){
+		Ticks::advance(50);
+		tempControl.pollSensors();
+		referenceBeer.poll();
+		referenceFridge.poll();
+	}
+	tempControl.beerSensor.update();
+	tempControl.fridgeSensor.update();
+	referenceBeer.update();
+	referenceFridge.update();
+}
+
+// The group does a full read when one of its sensors needs one, so the split between fast and full reads can
+// differ from the reference. The number of readings can't.
+static bool sameReadCount(TempSensor & a, TempSensor & b){
+	const TempSensorStats & statsA = a.getStats();
+	const TempSensorStats & statsB = b.getStats();
+	return statsA.fullReads + statsA.fastReads == statsB.fullReads + statsB.fastReads
+		&& statsA.crcErrors == 0 && statsB.crcErrors == 0 && statsA.presenceErrors == 0 && statsB.presenceErrors == 0
+		&& statsA.disconnects == 0 && statsB.disconnects == 0;
+}
+
+// Runs for a while with the fridge cycling and the beer slowly following. Returns the number of seconds in which
+// a lock-step reading differed from its reference.
+static uint16_t run(OneWireSimDevice & beer, OneWireSimDevice & referenceBeerDevice,
+		OneWireSimDevice & fridge, OneWireSimDevice & referenceFridgeDevice){
+	uint16_t differences = 0;
+	for(uint16_t t = 0; t < 1200; t++){
+		int16_t beerTemperature = 18*16 + (int16_t) (16 * sin(t / 300.0));
+		int16_t fridgeTemperature = 15*16 + (int16_t) (64 * sin(t / 60.0));
+		beer.setTemperature(beerTemperature);
+		referenceBeerDevice.setTemperature(beerTemperature);
+		fridge.setTemperature(fridgeTemperature);
+		referenceFridgeDevice.setTemperature(fridgeTemperature);
+		second();
+		if(tempControl.beerSensor.read() != referenceBeer.read() || tempControl.fridgeSensor.read() != referenceFridge.read()){
+			differences++;
+		}
+	}
+	return differences;
+}
+
+int main(void){
+	deviceRegistry.clear();
+	OneWireSimDevice beer(DS18B20MODEL, 0x000101);
+	OneWireSimDevice fridge(DS18B20MODEL, 0x000102);
+	OneWireSimDevice referenceBeerDevice(DS18B20MODEL, 0x000103);
+	OneWireSimDevice referenceFridgeDevice(DS18B20MODEL, 0x000104);
+	OneWireSimBus::forPin(beerSensorPin)->attach(&beer);
+	OneWireSimBus::forPin(fridgeSensorPin)->attach(&fridge);
+	OneWireSimBus::forPin(REFERENCE_BEER_PIN)->attach(&referenceBeerDevice);
+	OneWireSimBus::forPin(REFERENCE_FRIDGE_PIN)->attach(&referenceFridgeDevice);
+	tempControl.beerSensor.init();
+	tempControl.fridgeSensor.init();
+	referenceBeer.init();
+	referenceFridge.init();
+	
+	CHECK(run(beer, referenceBeerDevice, fridge, referenceFridgeDevice) == 0);
+	CHECK(tempControl.beerSensor.isConnected() && tempControl.fridgeSensor.isConnected());
+	CHECK(sameReadCount(tempControl.beerSensor, referenceBeer));
+	CHECK(sameReadCount(tempControl.fridgeSensor, referenceFridge));
+	CHECK(tempControl.beerSensor.getStats().fastReads > 0);
+	printf("DS18B20 pair: %u full and %u fast reads\n",
+		tempControl.beerSensor.getStats().fullReads, tempControl.beerSensor.getStats().fastReads);
+	
+	// The DS18S20 can't do fast reads. When the fridge sensor is replaced by one, the beer sensor reads the
+	// full scratchpad in the lock-step group, but not on its own pin.
+	OneWireSimDevice fridgeDS18S20(DS18S20MODEL, 0x000105);
+	OneWireSimDevice referenceFridgeDS18S20(DS18S20MODEL, 0x000106);
+	OneWireSimBus::forPin(fridgeSensorPin)->detach(&fridge);
+	OneWireSimBus::forPin(REFERENCE_FRIDGE_PIN)->detach(&referenceFridgeDevice);
+	OneWireSimBus::forPin(fridgeSensorPin)->attach(&fridgeDS18S20);
+	OneWireSimBus::forPin(REFERENCE_FRIDGE_PIN)->attach(&referenceFridgeDS18S20);
+	run(beer, referenceBeerDevice, fridgeDS18S20, referenceFridgeDS18S20); // finds the new devices
+	TempSensorStats beerBefore = tempControl.beerSensor.getStats();
+	TempSensorStats referenceBefore = referenceBeer.getStats();
+	CHECK(run(beer, referenceBeerDevice, fridgeDS18S20, referenceFridgeDS18S20) == 0);
+	CHECK(tempControl.fridgeSensor.isConnected() && referenceFridge.isConnected());
+	CHECK(tempControl.beerSensor.getStats().fastReads == beerBefore.fastReads);
+	CHECK(tempControl.beerSensor.getStats().fullReads > beerBefore.fullReads);
+	CHECK(referenceBeer.getStats().fastReads > referenceBefore.fastReads);
+	
+	return hostTestResult("LockStepTest");
+}
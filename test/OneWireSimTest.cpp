@@ -0,0 +1,250 @@
+/*
+ * Runs the 1-Wire stack (OneWire, DallasTemperature and TempSensor) on the simulated bus of OneWireSim.h:
+ * search and alarm search, conversions at each resolution, the DS18S20, the bus time counters, unplugging and
+ * replugging a device, and injected presence, write and read errors, which must show up in the sensor statistics.
+ * Built with REQUIRESALARMS, see the Makefile.
+ */
+
+#include "OneWire.h"
+#include "OneWireSim.h"
+#include "DallasTemperature.h"
+#include "TempSensor.h"
+#include "Ticks.h"
+#include "HostTest.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SEARCH_PIN 2
+#define SENSOR_PIN 3
+
+static OneWireSimDevice ds18b20(DS18B20MODEL, 0x123456);
+static OneWireSimDevice ds18s20(DS18S20MODEL, 0x654321);
+static OneWireSimDevice ds1822(DS1822MODEL, 0x000001);
+
+static void search(OneWire & oneWire){
+	OneWireSimDevice * devices[] = {&ds18b20, &ds18s20, &ds1822};
+	bool found[3] = {false, false, false};
+	uint8_t count = 0;
+	uint8_t address[8];
+	oneWire.reset_search();
+	while(oneWire.search(address)){
+		count++;
+		CHECK(OneWire::crc8(address, 7) == address[7]);
+		for(uint8_t i = 0; i < 3; i++){
+			if(memcmp(address, devices[i]->getAddress(), 8) == 0){
+				found[i] = true;
+			}
+		}
+	}
+	CHECK(count == 3);
+	CHECK(found[0] && found[1] && found[2]);
+}
+
+static void alarmSearch(DallasTemperature & sensors){
+	// only the DS18B20 leaves its window
+	ds18b20.setTemperature(30 << 4);
+	ds18s20.setTemperature(20 << 4);
+	ds1822.setTemperature(-5 << 4);
+	CHECK(sensors.setAlarmWindow((uint8_t *) ds18b20.getAddress(), 10, 25));
+	CHECK(sensors.setAlarmWindow((uint8_t *) ds18s20.getAddress(), 10, 25));
+	CHECK(sensors.setAlarmWindow((uint8_t *) ds1822.getAddress(), -10, 25));
+	sensors.requestTemperatures();
+	Ticks::advance(750);
+	uint8_t address[8];
+	uint8_t count = 0;
+	sensors.resetAlarmSearch();
+	while(sensors.alarmSearch(address)){
+		count++;
+		CHECK(memcmp(address, ds18b20.getAddress(), 8) == 0);
+	}
+	CHECK(count == 1);
+	
+	// and the DS1822 when it drops below its window
+	ds1822.setTemperature(-12 << 4);
+	sensors.requestTemperatures();
+	Ticks::advance(750);
+	count = 0;
+	sensors.resetAlarmSearch();
+	while(sensors.alarmSearch(address)){
+		count++;
+	}
+	CHECK(count == 2);
+}
+
+// conversion time and reading of each resolution
+static void resolutions(DallasTemperature & sensors){
+	uint8_t * address = (uint8_t *) ds18b20.getAddress();
+	const int16_t temperatures[] = {0x0191, -0x0191, 0x0007, -0x0001, 0x0550, -0x0370};
+	for(uint8_t bits = 9; bits <= 12; bits++){
+		CHECK(sensors.setResolution(address, bits, false));
+		CHECK(sensors.getResolution(address) == bits);
+		CHECK(ds18b20.getConversionTime() == DallasTemperature::millisToWaitForConversion(bits));
+		for(uint8_t i = 0; i < sizeof(temperatures)/sizeof(temperatures[0]); i++){
+			ds18b20.setTemperature(temperatures[i]);
+			CHECK(sensors.requestTemperaturesByAddress(address));
+			Ticks::advance(DallasTemperature::millisToWaitForConversion(bits) - 1);
+			CHECK(!sensors.isConversionComplete());
+			Ticks::advance(1);
+			CHECK(sensors.isConversionComplete());
+			// the undefined low bits are cleared, 1/16 degree is 32 in fixed7_9
+			long expected = (long) (temperatures[i] & ~((1 << (12 - bits)) - 1)) * 32;
+			expected = constrain(expected, -32767, 32767); // beyond the range of fixed7_9
+			CHECK(sensors.getTempFixed(address) == expected);
+			CHECK(sensors.getTempRaw(address) == (temperatures[i] & ~((1 << (12 - bits)) - 1)));
+		}
+	}
+	
+	// The DS18S20 has 9 bits and COUNT_REMAIN for the fraction, together 1/16 degree
+	address = (uint8_t *) ds18s20.getAddress();
+	CHECK(sensors.getResolution(address) == 9);
+	for(int16_t temperature = -20*16; temperature <= 40*16; temperature++){
+		ds18s20.setTemperature(temperature);
+		CHECK(sensors.requestTemperaturesByAddress(address));
+		Ticks::advance(750);
+		CHECK(sensors.getTempFixed(address) == temperature * 32);
+	}
+}
+
+// the bus counts slots and their time on a real wire
+static void busTime(OneWire & oneWire){
+	OneWireSimBus * bus = OneWireSimBus::forPin(SEARCH_PIN);
+	bus->clearStatistics();
+	CHECK(oneWire.reset());
+	oneWire.skip(); // 0xCC: 4 ones and 4 zeros
+	oneWire.write(STARTCONVO); // 0x44: 2 ones and 6 zeros
+	CHECK(bus->resets == 1);
+	CHECK(bus->writeSlots == 16);
+	CHECK(bus->readSlots == 0);
+	CHECK(bus->busTime == ONEWIRE_SIM_RESET_TIME + 6*ONEWIRE_SIM_WRITE_ONE_TIME + 10*ONEWIRE_SIM_WRITE_ZERO_TIME);
+	oneWire.read();
+	CHECK(bus->readSlots == 8);
+	CHECK(bus->busTime == ONEWIRE_SIM_RESET_TIME + 6*ONEWIRE_SIM_WRITE_ONE_TIME + 10*ONEWIRE_SIM_WRITE_ZERO_TIME
+		+ 8*ONEWIRE_SIM_READ_TIME);
+	Ticks::advance(750);
+}
+
+static OneWireSimDevice probe(DS18B20MODEL, 0xABCDEF);
+static TempSensorBus sensorBus(SENSOR_PIN);
+static TempSensor tempSensor(DEVICE_ROLE_AMBIENT, sensorBus);
+
+// one second of the main loop
+static void second(void){
+	for(uint8_t i = 0; i < 20; i++){
+		Ticks::advance(50);
+		tempSensor.poll();
+	}
+	tempSensor.update();
+}
+
+static void unplug(void){
+	probe.setTemperature(20 << 4);
+	tempSensor.init();
+	for(uint8_t i = 0; i < 10; i++){
+		second();
+	}
+	CHECK(tempSensor.isConnected());
+	CHECK(tempSensor.read() == 20 << 9);
+	
+	probe.setConnected(false);
+	for(uint8_t i = 0; i < 3; i++){
+		second();
+	}
+	CHECK(!tempSensor.isConnected());
+	CHECK(tempSensor.getStats().disconnects == 1);
+	
+	// unplugged for a minute, the sensor keeps trying with a growing interval
+	for(uint8_t i = 0; i < 60; i++){
+		second();
+	}
+	probe.setTemperature(21 << 4);
+	probe.setConnected(true);
+	uint8_t seconds = 0;
+	while(!tempSensor.isConnected() && seconds < 100){
+		second();
+		seconds++;
+	}
+	CHECK(tempSensor.isConnected());
+	CHECK(tempSensor.getStats().reconnects == 1);
+	CHECK(tempSensor.read() == 21 << 9);
+}
+
+struct ErrorCount{
+	unsigned long injected;
+	TempSensorStats stats;
+};
+
+// Runs for a while with an error rate on the bus and returns the errors that were injected and counted
+static void runWithErrors(uint16_t presence, uint16_t write, uint16_t read, ErrorCount & count){
+	OneWireSimBus * bus = OneWireSimBus::forPin(SENSOR_PIN);
+	TempSensorStats before = tempSensor.getStats();
+	bus->clearStatistics();
+	bus->setErrorRates(presence, write, read);
+	for(uint16_t i = 0; i < 2000; i++){
+		second();
+	}
+	bus->setErrorRates(0, 0, 0);
+	count.injected = bus->injectedErrors;
+	const TempSensorStats & after = tempSensor.getStats();
+	count.stats.crcErrors = after.crcErrors - before.crcErrors;
+	count.stats.presenceErrors = after.presenceErrors - before.presenceErrors;
+	count.stats.rejectedReads = after.rejectedReads - before.rejectedReads;
+	count.stats.disconnects = after.disconnects - before.disconnects;
+	count.stats.fullReads = after.fullReads - before.fullReads;
+	count.stats.fastReads = after.fastReads - before.fastReads;
+	printf("injected %lu errors: %u CRC errors, %u presence errors, %u rejected fast reads, %u disconnects"
+		" in %u full and %u fast reads\n", count.injected, count.stats.crcErrors, count.stats.presenceErrors,
+		count.stats.rejectedReads, count.stats.disconnects, count.stats.fullReads, count.stats.fastReads);
+	// the sensor recovers from all errors
+	for(uint8_t i = 0; i < 100 && !tempSensor.isConnected(); i++){
+		second();
+	}
+	CHECK(tempSensor.isConnected());
+}
+
+static void errors(void){
+	ErrorCount count;
+	
+	printf("presence errors: ");
+	runWithErrors(2000, 0, 0, count);
+	CHECK(count.injected > 0);
+	CHECK(count.stats.presenceErrors > 0);
+	CHECK(count.stats.presenceErrors <= count.injected);
+	CHECK(count.stats.crcErrors == 0);
+	
+	printf("write errors:    ");
+	runWithErrors(0, 100, 0, count);
+	CHECK(count.injected > 0);
+	CHECK(count.stats.crcErrors + count.stats.rejectedReads > 0);
+	CHECK(count.stats.crcErrors + count.stats.rejectedReads <= count.injected);
+	CHECK(count.stats.presenceErrors == 0);
+	
+	printf("read errors:     ");
+	runWithErrors(0, 0, 100, count);
+	CHECK(count.injected > 0);
+	CHECK(count.stats.crcErrors > 0);
+	CHECK(count.stats.crcErrors + count.stats.rejectedReads <= count.injected);
+	CHECK(count.stats.presenceErrors == 0);
+}
+
+int main(void){
+	srand(1);
+	deviceRegistry.clear();
+	OneWireSimBus * bus = OneWireSimBus::forPin(SEARCH_PIN);
+	bus->attach(&ds18b20);
+	bus->attach(&ds18s20);
+	bus->attach(&ds1822);
+	OneWire oneWire(SEARCH_PIN);
+	DallasTemperature sensors(&oneWire);
+	sensors.begin();
+	
+	search(oneWire);
+	alarmSearch(sensors);
+	resolutions(sensors);
+	busTime(oneWire);
+	
+	OneWireSimBus::forPin(SENSOR_PIN)->attach(&probe);
+	unplug();
+	errors();
+	
+	return hostTestResult("OneWireSimTest");
+}
@@ -0,0 +1,210 @@
+/*
+ * Sends the commands written by ParameterSweep::writeCommands to the real parser (PiLink::receive) through the
+ * simulated serial port at 57600 baud, and checks that the controller ends up with the constants of the candidate.
+ * Also checks that the ranking written by writeRanking, the output of ParameterSweepTool, is valid JSON.
+ */
+
+#include "ParameterSweep.h"
+#include "PiLink.h"
+#include "HostTest.h"
+#include <string.h>
+#include <ctype.h>
+
+#define MAX_TEXT 1024
+#define MAX_RANKING 65536
+
+// reads the file from the start into text
+static void readFile(FILE * file, char * text){
+	rewind(file);
+	size_t length = fread(text, 1, MAX_TEXT - 1, file);
+	text[length] = 0;
+}
+
+// sends a line and lets the controller process it, one loop pass per ms
+static void sendLine(const char * line){
+	Serial.send(line);
+	while(Serial.sending() || Serial.available()){
+		piLink.receive();
+		delay(1);
+	}
+}
+
+static void skipSpace(const char * & p){
+	while(isspace(*p)){
+		p++;
+	}
+}
+
+// Returns true when p starts with a JSON value, and moves p past it
+static bool parseJsonValue(const char * & p){
+	skipSpace(p);
+	if(*p == '{' || *p == '['){
+		char close = (*p == '{') ? '}' : ']';
+		bool object = (*p == '{');
+		p++;
+		skipSpace(p);
+		if(*p == close){
+			p++;
+			return true;
+		}
+		while(true){
+			if(object){
+				skipSpace(p);
+				if(*p != '"' || !parseJsonValue(p)){
+					return false; // the key must be a string
+				}
+				skipSpace(p);
+				if(*p++ != ':'){
+					return false;
+				}
+			}
+			if(!parseJsonValue(p)){
+				return false;
+			}
+			skipSpace(p);
+			if(*p == close){
+				p++;
+				return true;
+			}
+			if(*p++ != ','){
+				return false;
+			}
+		}
+	}
+	if(*p == '"'){
+		for(p++; *p != '"'; p++){
+			if(*p == 0 || (unsigned char) *p < ' '){
+				return false;
+			}
+			if(*p == '\\' && *++p == 0){
+				return false;
+			}
+		}
+		p++;
+		return true;
+	}
+	if(strncmp(p, "true", 4) == 0 || strncmp(p, "null", 4) == 0){
+		p += 4;
+		return true;
+	}
+	if(strncmp(p, "false", 5) == 0){
+		p += 5;
+		return true;
+	}
+	// number: -?digits[.digits][(e|E)[+-]digits]
+	if(*p == '-'){
+		p++;
+	}
+	if(!isdigit(*p)){
+		return false;
+	}
+	while(isdigit(*p)){
+		p++;
+	}
+	if(*p == '.'){
+		p++;
+		if(!isdigit(*p)){
+			return false;
+		}
+		while(isdigit(*p)){
+			p++;
+		}
+	}
+	if(*p == 'e' || *p == 'E'){
+		p++;
+		if(*p == '+' || *p == '-'){
+			p++;
+		}
+		if(!isdigit(*p)){
+			return false;
+		}
+		while(isdigit(*p)){
+			p++;
+		}
+	}
+	return true;
+}
+
+static bool isJson(const char * text){
+	const char * p = text;
+	if(!parseJsonValue(p)){
+		return false;
+	}
+	skipSpace(p);
+	return *p == 0;
+}
+
+static void settingsToString(const ControlConstants & constants, char * text){
+	FILE * file = tmpfile();
+	ParameterSweep::writeSettings(file, constants);
+	readFile(file, text);
+	fclose(file);
+}
+
+int main(void){
+	SweepScenario scenario = ParameterSweep::defaultScenario();
+	scenario.seconds = 12*3600L;
+	ParameterSweep sweep(scenario);
+	CHECK(sweep.run(12, 4, 1));
+	CHECK(sweep.getNumRanked() > 0);
+	
+	char expected[MAX_TEXT];
+	char received[MAX_TEXT];
+	char line[MAX_TEXT];
+	for(uint16_t rank = 0; rank < sweep.getNumRanked(); rank++){
+		tempControl.loadDefaultConstants();
+		FILE * commands = tmpfile();
+		sweep.writeCommands(commands, rank, 'C');
+		rewind(commands);
+		while(fgets(line, sizeof(line), commands)){
+			CHECK(strlen(line) <= SWEEP_COMMAND_LENGTH);
+			sendLine(line);
+		}
+		fclose(commands);
+		settingsToString(sweep.getRanked(rank).constants, expected);
+		settingsToString(tempControl.cc, received);
+		CHECK(strcmp(expected, received) == 0);
+	}
+	CHECK(Serial.getOverruns() == 0);
+	
+	// the ranking is valid JSON and has an entry per candidate. Writing it does not change the temperature format.
+	CHECK(isJson("[{\"a\":\"1\",\"b\":[-1.5e3,true]}]") && !isJson("[{\"a\":1,}]") && !isJson("{\"a\" 1}"));
+	tempControl.cc.tempFormat = 'F';
+	FILE * rankingFile = tmpfile();
+	sweep.writeRanking(rankingFile);
+	CHECK(tempControl.cc.tempFormat == 'F');
+	rewind(rankingFile);
+	static char ranking[MAX_RANKING];
+	size_t rankingLength = fread(ranking, 1, sizeof(ranking) - 1, rankingFile);
+	ranking[rankingLength] = 0;
+	fclose(rankingFile);
+	CHECK(rankingLength < sizeof(ranking) - 1);
+	CHECK(isJson(ranking));
+	uint16_t entries = 0;
+	for(const char * p = ranking; (p = strstr(p, "\"rank\":")) != 0; p++){
+		entries++;
+	}
+	CHECK(entries == sweep.getNumRanked());
+	FILE * commandFile = tmpfile();
+	sweep.writeCommands(commandFile, 0, 'C');
+	fclose(commandFile);
+	CHECK(tempControl.cc.tempFormat == 'F');
+	tempControl.cc.tempFormat = 'C';
+	
+	// all settings on one line, as writeCommands used to write them, do not fit in the receive buffer
+	tempControl.loadDefaultConstants();
+	FILE * file = tmpfile();
+	fputc('j', file);
+	ParameterSweep::writeSettings(file, sweep.getRanked(0).constants);
+	fputc('\n', file);
+	readFile(file, line);
+	fclose(file);
+	sendLine(line);
+	settingsToString(sweep.getRanked(0).constants, expected);
+	settingsToString(tempControl.cc, received);
+	printf("one line of %u characters: %u characters lost\n", (unsigned) strlen(line), Serial.getOverruns());
+	CHECK(Serial.getOverruns() > 0);
+	CHECK(strcmp(expected, received) != 0);
+	
+	return hostTestResult("ParameterSweepTest");
+}
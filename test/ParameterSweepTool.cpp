@@ -0,0 +1,30 @@
+/*
+ * Searches the control constants with ParameterSweep, see sim/ParameterSweep.h, and prints the ranked Pareto set as
+ * JSON. Usage: ParameterSweepTool count workers seed
+ * Simulates count random candidates, with up to workers simulations at the same time. The same seed gives the same
+ * candidates. The settings of a candidate can be sent to the controller with the 'j' command.
+ */
+
+#include "ParameterSweep.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char * argv[]){
+	if(argc != 4){
+		fprintf(stderr, "usage: %s count workers seed\n", argv[0]);
+		return 2;
+	}
+	long count = atol(argv[1]);
+	long workers = atol(argv[2]);
+	if(count < 1 || count > 0xFFFF || workers < 1 || workers > 0xFF){
+		fprintf(stderr, "count must be 1 to 65535, workers 1 to 255\n");
+		return 2;
+	}
+	ParameterSweep sweep(ParameterSweep::defaultScenario());
+	if(!sweep.run(count, workers, strtoul(argv[3], 0, 10))){
+		fprintf(stderr, "not enough memory for %ld results\n", count);
+		return 1;
+	}
+	sweep.writeRanking(stdout);
+	return 0;
+}
@@ -0,0 +1,140 @@
+/*
+ * Checks the reconnection state machine of TempSensor on the simulated bus: the attempts to find a missing device
+ * back off exponentially up to TEMP_SENSOR_RETRY_MAX seconds, a found device is debounced for
+ * TEMP_SENSOR_DEBOUNCE_SAMPLES readings before it is used, and no call waits: the virtual time only moves in the test.
+ */
+
+#include "OneWire.h"
+#include "OneWireSim.h"
+#include "TempSensor.h"
+#include "Ticks.h"
+#include "HostTest.h"
+#include <stdio.h>
+
+#define SENSOR_PIN 8
+
+static TempSensorBus sensorBus(SENSOR_PIN);
+static TempSensor tempSensor(DEVICE_ROLE_BEER, sensorBus);
+static OneWireSimDevice probe(DS18B20MODEL, 0x0A0B0C);
+static unsigned long seconds = 0;
+static bool stalled = false;
+
+// one second of the main loop, returns true when the sensor tried to find its device
+static bool second(void){
+	OneWireSimBus * bus = OneWireSimBus::forPin(SENSOR_PIN);
+	bool searched = false;
+	for(uint8_t i = 0; i < 20; i++){
+		Ticks::advance(50);
+		unsigned long resets = bus->resets;
+		uint16_t fullReads = tempSensor.getStats().fullReads;
+		ticks_millis_t start = ticks.millis();
+		tempSensor.poll();
+		stalled = stalled || ticks.millis() != start;
+		// an attempt uses the bus without reading, a failed read of a lost device is counted as a full read
+		searched = searched || (bus->resets != resets && tempSensor.getStats().fullReads == fullReads);
+	}
+	ticks_millis_t start = ticks.millis();
+	tempSensor.update();
+	stalled = stalled || ticks.millis() != start;
+	seconds++;
+	return searched;
+}
+
+// Stores the seconds before each of the next count attempts to find the device
+static void attemptIntervals(unsigned long * intervals, uint8_t count){
+	unsigned long last = seconds;
+	for(uint8_t i = 0; i < count; ){
+		if(second()){
+			intervals[i++] = seconds - last;
+			last = seconds;
+		}
+	}
+}
+
+static void checkBackOff(const char * name){
+	unsigned long intervals[9];
+	attemptIntervals(intervals, 9);
+	printf("%s, seconds between attempts:", name);
+	for(uint8_t i = 0; i < 9; i++){
+		printf(" %lu", intervals[i]);
+	}
+	printf("\n");
+	// update() counts down the interval, the attempt is made by the next poll() after it reaches zero
+	unsigned long expected = intervals[0];
+	for(uint8_t i = 1; i < 9; i++){
+		expected = (expected < TEMP_SENSOR_RETRY_MAX) ? expected * 2 : TEMP_SENSOR_RETRY_MAX;
+		CHECK(intervals[i] == expected);
+	}
+}
+
+// Plugs in the probe and returns the number of seconds until the sensor is connected
+static unsigned long plugIn(int16_t temperature){
+	probe.setTemperature(temperature);
+	probe.setConnected(true);
+	unsigned long start = seconds;
+	while(!second() && seconds - start < 200){
+	}
+	// The attempt that found the probe started its first conversion, which completes in the same second.
+	// That reading and the next TEMP_SENSOR_DEBOUNCE_SAMPLES - 1 are discarded, the one after that is used.
+	unsigned long found = seconds;
+	while(!tempSensor.isConnected() && seconds - start < 200){
+		second();
+	}
+	CHECK(seconds - found == TEMP_SENSOR_DEBOUNCE_SAMPLES);
+	return seconds - start;
+}
+
+int main(void){
+	deviceRegistry.clear();
+	OneWireSimBus::forPin(SENSOR_PIN)->attach(&probe);
+	probe.setConnected(false);
+	
+	// missing at startup
+	tempSensor.init(); // the first attempt
+	second(); // init() is not followed by an update() in the same second
+	checkBackOff("missing at startup");
+	CHECK(!tempSensor.isConnected());
+	
+	// The probe is found at the next attempt, at most TEMP_SENSOR_RETRY_MAX + 1 seconds later. It is debounced
+	// for TEMP_SENSOR_DEBOUNCE_SAMPLES conversions of less than a second each.
+	unsigned long connectTime = plugIn(20 << 4);
+	printf("connected after %lu seconds\n", connectTime);
+	CHECK(connectTime <= TEMP_SENSOR_RETRY_MAX + 1 + TEMP_SENSOR_DEBOUNCE_SAMPLES + 1);
+	CHECK(tempSensor.isConnected());
+	CHECK(tempSensor.read() == 20 << 9);
+	CHECK(tempSensor.readFastFiltered() == 20 << 9); // the filters start at the first reading
+	CHECK(tempSensor.getStats().reconnects == 0); // it was never connected before
+	
+	// Unplugged, the next attempt is made a second later, then the interval doubles again
+	probe.setConnected(false);
+	while(tempSensor.isConnected() && seconds < 1000){
+		second();
+	}
+	CHECK(tempSensor.getStats().disconnects == 1);
+	checkBackOff("unplugged");
+	
+	// A bad contact: the probe is found, but gone again before it is debounced. That counts as a failed attempt,
+	// so the interval does not start again at one second.
+	probe.setConnected(true);
+	OneWireSimBus * bus = OneWireSimBus::forPin(SENSOR_PIN);
+	unsigned long resets = bus->resets;
+	while(bus->resets == resets){
+		second();
+	}
+	probe.setConnected(false);
+	unsigned long interval;
+	attemptIntervals(&interval, 1);
+	printf("bad contact, seconds to the next attempt: %lu\n", interval);
+	CHECK(interval >= TEMP_SENSOR_RETRY_MAX);
+	CHECK(!tempSensor.isConnected());
+	CHECK(tempSensor.getStats().disconnects == 1);
+	
+	connectTime = plugIn(21 << 4);
+	printf("reconnected after %lu seconds\n", connectTime);
+	CHECK(tempSensor.isConnected());
+	CHECK(tempSensor.getStats().reconnects == 1);
+	CHECK(tempSensor.read() == 21 << 9);
+	
+	CHECK(!stalled);
+	return hostTestResult("ReconnectTest");
+}
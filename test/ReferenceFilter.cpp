@@ -0,0 +1,81 @@
+/*
+ * See ReferenceFilter.h
+ */
+
+#include "ReferenceFilter.h"
+#include <limits.h>
+
+fixed7_25 ReferenceFixedFilter::addDoublePrecision(fixed7_25 val){
+	xv[2] = xv[1];
+	xv[1] = xv[0];
+	xv[0] = val;
+	
+	yv[2] = yv[1];
+	yv[1] = yv[0];
+	
+	/* Implementation that prevents overflow as much as possible by order of operations: */
+	yv[0] = ((yv[1] - yv[2]) + yv[1]) // expected value + 1*
+	- (yv[1]>>b) + (yv[2]>>b) + // expected value +0*
+	+ (xv[0]>>a) + (xv[1]>>(a-1)) + (xv[2]>>a) // expected value +(1>>(a-2))
+	- (yv[2]>>(a-2)); // expected value -(1>>(a-2))
+	
+	return yv[0];
+}
+
+void ReferenceFixedFilter::init(fixed7_9 val){
+	xv[0] = val;
+	xv[0] = xv[0]<<16; // 16 extra bits are used in the filter for the fraction part
+	
+	xv[1] = xv[0];
+	xv[2] = xv[0];
+	
+	yv[0] = xv[0];
+	yv[1] = xv[0];
+	yv[2] = xv[0];
+}
+
+fixed7_9 ReferenceFixedFilter::detectPosPeak(void){
+	if(yv[0] < yv[1] && yv[1] >= yv[2]){
+		return yv[1]>>16;
+	}
+	else{
+		return INT_MIN;
+	}
+}
+
+fixed7_9 ReferenceFixedFilter::detectNegPeak(void){
+	if(yv[0] > yv[1] && yv[1] <= yv[2]){
+		return yv[1]>>16;
+	}
+	else{
+		return INT_MIN;
+	}
+}
+
+ReferenceCascadedFilter::ReferenceCascadedFilter(uint8_t count){
+	numSections = count;
+	setCoefficients(2);
+}
+
+void ReferenceCascadedFilter::init(fixed7_9 val){
+	for(uint8_t i=0; i<numSections; i++){
+		sections[i].init(val);
+	}
+}
+
+void ReferenceCascadedFilter::setCoefficients(uint8_t bValue){
+	for(uint8_t i=0; i<numSections; i++){
+		sections[i].setCoefficients(bValue);
+	}
+}
+
+fixed7_9 ReferenceCascadedFilter::add(fixed7_9 val){
+	return addDoublePrecision(((fixed7_25) val) << 16) >> 16;
+}
+
+fixed7_25 ReferenceCascadedFilter::addDoublePrecision(fixed7_25 val){
+	for(uint8_t i=0; i<numSections; i++){
+		val = sections[i].addDoublePrecision(val);
+	}
+	return val;
+}
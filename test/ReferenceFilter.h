@@ -0,0 +1,62 @@
+/*
+ * The filter as it was before the sections shared their delay lines and before the specialized
+ * steps. Each section stores its own input and output arrays and shifts by its a and b members.
+ * FilterTest compares CascadedFilter against it.
+ */
+
+#ifndef REFERENCE_FILTER_H_
+#define REFERENCE_FILTER_H_
+
+#include "temperatureFormats.h"
+
+#define REFERENCE_FILTER_MAX_SECTIONS 4
+
+class ReferenceFixedFilter{
+	public:
+	fixed7_25 xv[3];
+	fixed7_25 yv[3];
+	uint8_t a;
+	uint8_t b;
+	
+	void init(fixed7_9 val);
+	void setCoefficients(uint8_t bValue){
+		a = bValue*2+4;
+		b = bValue;
+	}
+	fixed7_25 addDoublePrecision(fixed7_25 val);
+	fixed7_9 detectPosPeak(void);
+	fixed7_9 detectNegPeak(void);
+};
+
+class ReferenceCascadedFilter{
+	public:
+	ReferenceFixedFilter sections[REFERENCE_FILTER_MAX_SECTIONS];
+	uint8_t numSections;
+	
+	ReferenceCascadedFilter(uint8_t count);
+	void init(fixed7_9 val);
+	void setCoefficients(uint8_t bValue);
+	fixed7_9 add(fixed7_9 val);
+	fixed7_25 addDoublePrecision(fixed7_25 val);
+	
+	fixed7_9 readInput(void){
+		return sections[0].xv[0]>>16;
+	}
+	fixed7_9 readOutput(void){
+		return sections[numSections-1].yv[0]>>16;
+	}
+	fixed7_25 readOutputDoublePrecision(void){
+		return sections[numSections-1].yv[0];
+	}
+	fixed7_25 readPrevOutputDoublePrecision(void){
+		return sections[numSections-1].yv[1];
+	}
+	fixed7_9 detectPosPeak(void){
+		return sections[numSections-1].detectPosPeak();
+	}
+	fixed7_9 detectNegPeak(void){
+		return sections[numSections-1].detectNegPeak();
+	}
+};
+
+#endif /* REFERENCE_FILTER_H_ */
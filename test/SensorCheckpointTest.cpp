@@ -0,0 +1,57 @@
+/*
+ * Checks which EEPROM contents and reset causes let SensorCheckpoint::restore pass a checkpoint to the sensors.
+ */
+
+#include "SensorCheckpoint.h"
+#include "TempControl.h"
+#include "OneWire.h"
+#include "HostTest.h"
+#include <avr/eeprom.h>
+#include <avr/io.h>
+#include <stddef.h>
+
+static void writeSlot(uint8_t index, uint8_t format, uint8_t sequence){
+	SensorCheckpointSlot slot;
+	slot.format = format;
+	slot.sequence = sequence;
+	slot.beer.temperature = 20*512;
+	slot.beer.slope = 256;
+	slot.fridge.temperature = 18*512;
+	slot.fridge.slope = -128;
+	slot.crc = OneWire::crc8((uint8_t *) &slot, offsetof(SensorCheckpointSlot, crc));
+	eeprom_update_block((void *) &slot, (void *) (EEPROM_CHECKPOINT_ADDRESS + index*sizeof(SensorCheckpointSlot)), sizeof(SensorCheckpointSlot));
+}
+
+static bool restoreAfter(uint8_t resetFlags){
+	MCUSR = resetFlags;
+	return SensorCheckpoint::restore();
+}
+
+int main(void){
+	// nothing valid stored
+	hostEepromFill(0x00);
+	CHECK(!restoreAfter(_BV(EXTRF)));
+	hostEepromFill(0xFF);
+	CHECK(!restoreAfter(_BV(EXTRF)));
+	
+	// written by another firmware version
+	writeSlot(1, EEPROM_FORMAT_VERSION - 1, 7);
+	CHECK(!restoreAfter(_BV(EXTRF)));
+	
+	// a partial write
+	writeSlot(2, EEPROM_FORMAT_VERSION, 8);
+	eeprom_write_byte((uint8_t *) (EEPROM_CHECKPOINT_ADDRESS + 2*sizeof(SensorCheckpointSlot) + 3), 0x55);
+	CHECK(!restoreAfter(_BV(EXTRF)));
+	
+	// a valid checkpoint is only used after a reset by the reset pin or the watchdog
+	writeSlot(3, EEPROM_FORMAT_VERSION, 9);
+	CHECK(restoreAfter(_BV(EXTRF)));
+	CHECK(restoreAfter(_BV(WDRF)));
+	CHECK(!restoreAfter(0));
+	CHECK(!restoreAfter(_BV(PORF)));
+	CHECK(!restoreAfter(_BV(PORF) | _BV(EXTRF)));
+	CHECK(!restoreAfter(_BV(BORF)));
+	CHECK(!restoreAfter(_BV(BORF) | _BV(WDRF)));
+	
+	return hostTestResult("SensorCheckpointTest");
+}
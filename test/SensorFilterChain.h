@@ -0,0 +1,50 @@
+/*
+ * The filters of a TempSensor, outside the sensor, so the host tests can feed them any signal.
+ * The coefficients are the defaults of TempControl for the beer sensor.
+ */
+
+#ifndef SENSOR_FILTER_CHAIN_H_
+#define SENSOR_FILTER_CHAIN_H_
+
+#include "DecimatingFilter.h"
+#include "SlopeEstimator.h"
+#include "TempSensor.h"
+#include "TestSignals.h"
+
+class SensorFilterChain{
+	public:
+	void init(fixed7_9 temperature){
+		slowFilter.setDecimation(TEMP_SENSOR_SLOW_DECIMATION);
+		slowFilter.setCoefficientsForInputRate(5); // beerSlowFilter
+		slopeFilter.setDecimation(TEMP_SENSOR_SLOPE_DECIMATION);
+		slopeFilter.setDifferentiate(true);
+		slopeFilter.setCoefficients(4); // beerSlopeFilter
+		slowFilter.init(temperature);
+		slopeFilter.init(temperature);
+		estimator.init(temperature);
+	}
+	void add(fixed7_9 temperature){
+		slowFilter.add(temperature);
+		slopeFilter.addDoublePrecision(slowFilter.readOutputDoublePrecision());
+		estimator.add(temperature);
+	}
+	// degrees, as TempSensor::readSlowFiltered
+	double temperature(void){
+		return toDegrees(slowFilter.readOutput());
+	}
+	// degrees per hour, as TempSensor::readSlope with TEMP_SENSOR_SLOPE_REGRESSION 0
+	double filterSlope(void){
+		return toDegrees((slopeFilter.readOutputDoublePrecision() * (3600/TEMP_SENSOR_SLOPE_DECIMATION)) >> 16);
+	}
+	// degrees per hour, as TempSensor::readSlope with TEMP_SENSOR_SLOPE_REGRESSION 1
+	double estimatorSlope(void){
+		return toDegrees(estimator.readSlope());
+	}
+	
+	private:
+	DecimatingFilter slowFilter;
+	DecimatingFilter slopeFilter;
+	SlopeEstimator estimator;
+};
+
+#endif /* SENSOR_FILTER_CHAIN_H_ */
@@ -0,0 +1,144 @@
+/*
+ * Sends the 'h' command to the real parser (PiLink::receive) through the simulated serial port and checks the
+ * health report of the beer and fridge sensors: one line per sensor, with every counter of TempSensorStats.
+ * Read errors on the fridge bus and an unplugged beer probe make the counters differ from zero.
+ */
+
+#include "OneWire.h"
+#include "OneWireSim.h"
+#include "TempSensor.h"
+#include "TempControl.h"
+#include "PiLink.h"
+#include "Ticks.h"
+#include "HostTest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LINE 512
+#define MAX_PAIRS 16
+
+// the keys of the health report, in order
+static const char * const keys[] = {"role", "pin", "connected", "res", "fastReads", "fullReads", "rejected", "crcErr",
+	"presenceErr", "disconnects", "reconnects", "readMax", "readMean"};
+#define NUM_KEYS (sizeof(keys)/sizeof(keys[0]))
+
+struct HealthReport{
+	uint8_t numPairs;
+	char keys[MAX_PAIRS][16];
+	unsigned long values[MAX_PAIRS];
+};
+
+// one second of the main loop
+static void second(void){
+	for(uint8_t i = 0; i < 20; i++){
+		Ticks::advance(50);
+		tempControl.pollSensors();
+	}
+	tempControl.beerSensor.update();
+	tempControl.fridgeSensor.update();
+}
+
+// Parses H:{"key":"value",...}. Returns false when the line does not have this form.
+static bool parseReport(const char * line, HealthReport & report){
+	report.numPairs = 0;
+	if(strncmp(line, "H:{", 3) != 0){
+		return false;
+	}
+	const char * p = line + 3;
+	while(report.numPairs < MAX_PAIRS){
+		int length = 0;
+		unsigned long value;
+		if(sscanf(p, "\"%15[^\"]\":\"%lu\"%n", report.keys[report.numPairs], &value, &length) != 2 || length == 0){
+			return false;
+		}
+		report.values[report.numPairs++] = value;
+		p += length;
+		if(*p == '}'){
+			return strcmp(p, "}\n") == 0;
+		}
+		if(*p++ != ','){
+			return false;
+		}
+	}
+	return false;
+}
+
+static void checkReport(const HealthReport & report, TempSensor & sensor){
+	CHECK(report.numPairs == NUM_KEYS);
+	for(uint8_t i = 0; i < report.numPairs && i < NUM_KEYS; i++){
+		CHECK(strcmp(report.keys[i], keys[i]) == 0);
+	}
+	if(report.numPairs != NUM_KEYS){
+		return;
+	}
+	const TempSensorStats & stats = sensor.getStats();
+	const unsigned long expected[] = {sensor.getRole(), sensor.getPin(), sensor.isConnected(), sensor.getResolution(),
+		stats.fastReads, stats.fullReads, stats.rejectedReads, stats.crcErrors, stats.presenceErrors,
+		stats.disconnects, stats.reconnects, stats.maxReadTime, sensor.getMeanReadTime()}; // times are 0 on the virtual clock
+	for(uint8_t i = 0; i < NUM_KEYS; i++){
+		if(report.values[i] != expected[i]){
+			printf("%s: %lu, expected %lu\n", keys[i], report.values[i], expected[i]);
+		}
+		CHECK(report.values[i] == expected[i]);
+	}
+}
+
+int main(void){
+	deviceRegistry.clear();
+	OneWireSimDevice beer(DS18B20MODEL, 0x00AA01);
+	OneWireSimDevice fridge(DS18B20MODEL, 0x00AA02);
+	beer.setTemperature(20 << 4);
+	fridge.setTemperature(4 << 4);
+	OneWireSimBus::forPin(beerSensorPin)->attach(&beer);
+	OneWireSimBus::forPin(fridgeSensorPin)->attach(&fridge);
+	tempControl.beerSensor.init();
+	tempControl.fridgeSensor.init();
+	
+	srand(15);
+	OneWireSimBus::forPin(fridgeSensorPin)->setErrorRates(500, 0, 100);
+	for(uint16_t t = 0; t < 600; t++){
+		if(t == 100){
+			beer.setConnected(false);
+		}
+		if(t == 110){
+			beer.setConnected(true);
+		}
+		second();
+	}
+	OneWireSimBus::forPin(fridgeSensorPin)->setErrorRates(0, 0, 0);
+	for(uint8_t t = 0; t < 100 && !tempControl.fridgeSensor.isConnected(); t++){
+		second();
+	}
+	CHECK(tempControl.beerSensor.isConnected() && tempControl.fridgeSensor.isConnected());
+	CHECK(tempControl.beerSensor.getStats().reconnects == 1);
+	CHECK(tempControl.fridgeSensor.getStats().crcErrors > 0);
+	CHECK(tempControl.fridgeSensor.getStats().presenceErrors > 0);
+	
+	FILE * output = tmpfile();
+	Serial.setOutput(output);
+	Serial.send("h");
+	while(Serial.sending() || Serial.available()){
+		piLink.receive();
+		delay(1);
+	}
+	Serial.setOutput(0);
+	
+	rewind(output);
+	char line[MAX_LINE];
+	HealthReport report;
+	TempSensor * const sensors[] = {&tempControl.beerSensor, &tempControl.fridgeSensor};
+	uint8_t numReports = 0;
+	while(fgets(line, sizeof(line), output) != 0){
+		printf("%s", line);
+		CHECK(parseReport(line, report));
+		if(numReports < 2){
+			checkReport(report, *sensors[numReports]);
+		}
+		numReports++;
+	}
+	fclose(output);
+	CHECK(numReports == 2);
+	
+	return hostTestResult("SensorHealthTest");
+}
@@ -0,0 +1,157 @@
+/*
+ * Compares the least squares SlopeEstimator with the slope filter of TempSensor (TEMP_SENSOR_SLOPE_REGRESSION 0),
+ * on a ramp, a step and noise, with 12 bit sensor readings. The lag and noise of both are printed.
+ * The estimator is also checked against a floating point least squares fit.
+ *
+ * Pass a file with one temperature in degrees per line, one line per second, to compare both on recorded data.
+ */
+
+#include "SensorFilterChain.h"
+#include "HostTest.h"
+#include <stdio.h>
+
+// Time after the start of a 1 degree per hour ramp until the estimates reach half of it
+static void ramp(double noise){
+	SensorFilterChain chain;
+	chain.init(sensorReading(20));
+	long filterLag = -1;
+	long estimatorLag = -1;
+	for(long t = 1; t < 4*3600; t++){
+		double temperature = 20 + ((t > 600) ? (t - 600) / 3600.0 : 0);
+		chain.add(sensorReading(temperature + noise * gaussianNoise()));
+		if(filterLag < 0 && chain.filterSlope() >= 0.5){
+			filterLag = t - 600;
+		}
+		if(estimatorLag < 0 && chain.estimatorSlope() >= 0.5){
+			estimatorLag = t - 600;
+		}
+	}
+	printf("ramp of 1 deg/h, noise %.2f deg: half of the slope after %ld s (filter), %ld s (estimator)."
+		" After 3 hours: %.3f and %.3f deg/h\n", noise, filterLag, estimatorLag, chain.filterSlope(), chain.estimatorSlope());
+	CHECK(estimatorLag > 0 && estimatorLag < filterLag);
+	CHECK(fabs(chain.estimatorSlope() - 1) < 0.1 + 5 * noise);
+	CHECK(fabs(chain.filterSlope() - 1) < 0.1 + 5 * noise);
+}
+
+// Largest slope after a step of 1 degree and when it occurs
+static void step(void){
+	SensorFilterChain chain;
+	chain.init(sensorReading(20));
+	double filterPeak = 0;
+	double estimatorPeak = 0;
+	long filterTime = 0;
+	long estimatorTime = 0;
+	for(long t = 1; t < 3*3600; t++){
+		chain.add(sensorReading((t > 600) ? 21 : 20));
+		if(chain.filterSlope() > filterPeak){
+			filterPeak = chain.filterSlope();
+			filterTime = t - 600;
+		}
+		if(chain.estimatorSlope() > estimatorPeak){
+			estimatorPeak = chain.estimatorSlope();
+			estimatorTime = t - 600;
+		}
+	}
+	printf("step of 1 deg: peak slope %.2f deg/h after %ld s (filter), %.2f deg/h after %ld s (estimator)."
+		" After 3 hours: %.3f and %.3f deg/h\n", filterPeak, filterTime, estimatorPeak, estimatorTime, chain.filterSlope(), chain.estimatorSlope());
+	CHECK(fabs(chain.estimatorSlope()) < 0.01);
+	CHECK(fabs(chain.filterSlope()) < 0.01);
+}
+
+// RMS of the estimates at a constant temperature, which should be 0
+static void noise(double sigma){
+	SensorFilterChain chain;
+	chain.init(sensorReading(20));
+	double filterSquares = 0;
+	double estimatorSquares = 0;
+	long count = 0;
+	for(long t = 1; t < 24*3600; t++){
+		chain.add(sensorReading(20.03 + sigma * gaussianNoise()));
+		if(t > 3600){
+			filterSquares += chain.filterSlope() * chain.filterSlope();
+			estimatorSquares += chain.estimatorSlope() * chain.estimatorSlope();
+			count++;
+		}
+	}
+	printf("constant temperature, noise %.2f deg: rms slope %.3f deg/h (filter), %.3f deg/h (estimator)\n",
+		sigma, sqrt(filterSquares / count), sqrt(estimatorSquares / count));
+}
+
+// The estimator must give the same slope as a floating point fit through the same points
+static void leastSquares(void){
+	SlopeEstimator estimator;
+	estimator.init(0);
+	double points[SLOPE_ESTIMATOR_POINTS] = {0};
+	double sum = 0;
+	double maxError = 0;
+	for(long t = 0; t < 200000; t++){
+		fixed7_9 val = (rand() % 20000) - 10000;
+		estimator.add(val);
+		sum += val;
+		if((t + 1) % SLOPE_ESTIMATOR_INTERVAL != 0){
+			continue;
+		}
+		for(uint8_t i = 0; i < SLOPE_ESTIMATOR_POINTS - 1; i++){
+			points[i] = points[i+1];
+		}
+		points[SLOPE_ESTIMATOR_POINTS - 1] = (fixed7_9) (long) (sum / SLOPE_ESTIMATOR_INTERVAL);
+		sum = 0;
+		double n = SLOPE_ESTIMATOR_POINTS, sx = 0, sy = 0, sxy = 0, sxx = 0;
+		for(uint8_t i = 0; i < SLOPE_ESTIMATOR_POINTS; i++){
+			sx += i;
+			sy += points[i];
+			sxy += i * points[i];
+			sxx += i * i;
+		}
+		double slope = (n * sxy - sx * sy) / (n * sxx - sx * sx) * 3600 / SLOPE_ESTIMATOR_INTERVAL;
+		slope = constrain(slope, -32767, 32767);
+		if(fabs(slope - estimator.readSlope()) > maxError){
+			maxError = fabs(slope - estimator.readSlope());
+		}
+	}
+	printf("largest difference with a floating point fit: %.2f LSB\n", maxError);
+	CHECK(maxError <= 1);
+}
+
+static void recorded(const char * fileName){
+	FILE * file = fopen(fileName, "r");
+	if(!CHECK(file != 0)){
+		return;
+	}
+	SensorFilterChain chain;
+	double temperature;
+	long count = 0;
+	double filterSquares = 0;
+	double estimatorSquares = 0;
+	double differenceSquares = 0;
+	while(fscanf(file, "%lf", &temperature) == 1){
+		if(count++ == 0){
+			chain.init(sensorReading(temperature));
+			continue;
+		}
+		chain.add(sensorReading(temperature));
+		filterSquares += chain.filterSlope() * chain.filterSlope();
+		estimatorSquares += chain.estimatorSlope() * chain.estimatorSlope();
+		double difference = chain.filterSlope() - chain.estimatorSlope();
+		differenceSquares += difference * difference;
+	}
+	fclose(file);
+	if(count > 1){
+		printf("%s, %ld samples: rms slope %.3f deg/h (filter), %.3f deg/h (estimator), rms difference %.3f deg/h\n",
+			fileName, count, sqrt(filterSquares / (count - 1)), sqrt(estimatorSquares / (count - 1)), sqrt(differenceSquares / (count - 1)));
+	}
+}
+
+int main(int argc, char ** argv){
+	srand(1);
+	ramp(0);
+	ramp(0.02);
+	step();
+	noise(0.02);
+	noise(0.05);
+	leastSquares();
+	for(int i = 1; i < argc; i++){
+		recorded(argv[i]);
+	}
+	return hostTestResult("SlopeEstimatorTest");
+}
@@ -0,0 +1,28 @@
+/*
+ * Synthetic sensor signals for the host tests. The signals are in degrees, one sample per second.
+ */
+
+#ifndef TEST_SIGNALS_H_
+#define TEST_SIGNALS_H_
+
+#include "temperatureFormats.h"
+#include <stdlib.h>
+#include <math.h>
+
+// normally distributed noise with a standard deviation of 1
+static inline double gaussianNoise(void){
+	double u = (rand() + 1.0) / (RAND_MAX + 2.0);
+	double v = (rand() + 1.0) / (RAND_MAX + 2.0);
+	return sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+}
+
+// A reading of a 12 bit sensor: rounded to 1/16 degree, in fixed7_9
+static inline fixed7_9 sensorReading(double degrees){
+	return (fixed7_9) floor(degrees * 16 + 0.5) * 32;
+}
+
+static inline double toDegrees(long fixed){
+	return fixed / 512.0;
+}
+
+#endif /* TEST_SIGNALS_H_ */
@@ -0,0 +1,68 @@
+/*
+ * Arduino layer to build the firmware sources on a PC for the host tests.
+ * Only what the sources use is declared. The functions are in HostArduino.cpp.
+ */
+
+#ifndef HOST_ARDUINO_H_
+#define HOST_ARDUINO_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <avr/pgmspace.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define A4 22
+#define A5 23
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin); // returns the last value written to the pin
+void noInterrupts(void);
+void interrupts(void);
+void init(void);
+
+uint8_t digitalPinToPort(uint8_t pin);
+uint8_t digitalPinToBitMask(uint8_t pin);
+volatile uint8_t * portInputRegister(uint8_t port);
+volatile uint8_t * portOutputRegister(uint8_t port);
+volatile uint8_t * portModeRegister(uint8_t port);
+
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+#define min(a,b) ((a)<(b)?(a):(b))
+#define max(a,b) ((a)>(b)?(a):(b))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitvalue) (bitvalue ? bitSet(value, bit) : bitClear(value, bit))
+#define _BV(b) (1<<(b))
+
+#include "Print.h"
+#include "HostSerial.h"
+
+extern HostSerial Serial;
+extern void serialEventRun(void) __attribute__((weak));
+
+struct HostUSBDevice{
+	void attach(void){}
+};
+extern HostUSBDevice USBDevice;
+
+#endif /* HOST_ARDUINO_H_ */
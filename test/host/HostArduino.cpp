@@ -0,0 +1,292 @@
+/*
+ * Implementation of the host Arduino layer, see Arduino.h in this directory.
+ */
+
+#include <Arduino.h>
+#include <avr/eeprom.h>
+#include <util/delay.h>
+#include <stdarg.h>
+
+// Clock of the host layer, in microseconds. Only delay() and delayMicroseconds() move it.
+// The firmware is built with TICKS_VIRTUAL, so its own clock is separate and moved by the tests.
+static unsigned long hostMicros = 0;
+
+unsigned long millis(void){
+	return hostMicros / 1000;
+}
+
+unsigned long micros(void){
+	return hostMicros;
+}
+
+void delay(unsigned long ms){
+	hostMicros += ms * 1000;
+}
+
+void delayMicroseconds(unsigned int us){
+	hostMicros += us;
+}
+
+void _delay_us(double us){
+	hostMicros += (unsigned long) us;
+}
+
+void _delay_ms(double ms){
+	hostMicros += (unsigned long) (ms * 1000);
+}
+
+void init(void){
+}
+
+void noInterrupts(void){
+}
+
+void interrupts(void){
+}
+
+static uint8_t pins[64];
+
+void pinMode(uint8_t /* pin */, uint8_t /* mode */){
+}
+
+void digitalWrite(uint8_t pin, uint8_t value){
+	pins[pin & 63] = value;
+}
+
+int digitalRead(uint8_t pin){
+	return pins[pin & 63];
+}
+
+static volatile uint8_t ports[3];
+
+uint8_t digitalPinToPort(uint8_t /* pin */){
+	return 0;
+}
+
+uint8_t digitalPinToBitMask(uint8_t pin){
+	return 1 << (pin & 7);
+}
+
+volatile uint8_t * portInputRegister(uint8_t /* port */){
+	return &ports[0];
+}
+
+volatile uint8_t * portModeRegister(uint8_t /* port */){
+	return &ports[1];
+}
+
+volatile uint8_t * portOutputRegister(uint8_t /* port */){
+	return &ports[2];
+}
+
+volatile uint8_t SREG;
+volatile uint8_t SPCR, SPSR = 0xFF, SPDR;
+volatile uint8_t PINB, PORTB, DDRB, PINC, PORTC, DDRC, PIND, PORTD, DDRD;
+volatile uint8_t TCCR0A, TCCR1A, TCCR1B, TIMSK1, TIFR1, TCCR2A, TCCR2B, TCNT2, OCR2A, TIMSK2, TIFR2;
+volatile uint16_t TCNT1, OCR1A;
+volatile uint8_t MCUSR;
+volatile uint8_t EICRB, EIMSK, EIFR, PCICR, PCIFR, PCMSK0, PCMSK1, PCMSK2;
+
+static uint8_t eeprom[E2END + 1];
+static bool eepromErased = false;
+
+static void eepromErase(void){
+	if(!eepromErased){
+		memset(eeprom, 0xFF, sizeof(eeprom));
+		eepromErased = true;
+	}
+}
+
+void hostEepromFill(uint8_t value){
+	memset(eeprom, value, sizeof(eeprom));
+	eepromErased = true;
+}
+
+void eeprom_read_block(void * dest, const void * src, size_t size){
+	eepromErase();
+	memcpy(dest, &eeprom[(size_t) src], size);
+}
+
+void eeprom_update_block(const void * src, void * dest, size_t size){
+	eepromErase();
+	memcpy(&eeprom[(size_t) dest], src, size);
+}
+
+uint8_t eeprom_read_byte(const uint8_t * address){
+	eepromErase();
+	return eeprom[(size_t) address];
+}
+
+void eeprom_write_byte(uint8_t * address, uint8_t value){
+	eepromErase();
+	eeprom[(size_t) address] = value;
+}
+
+void eeprom_update_byte(uint8_t * address, uint8_t value){
+	eeprom_write_byte(address, value);
+}
+
+uint16_t eeprom_read_word(const uint16_t * address){
+	uint16_t value;
+	eeprom_read_block(&value, address, sizeof(value));
+	return value;
+}
+
+void eeprom_update_word(uint16_t * address, uint16_t value){
+	eeprom_update_block(&value, address, sizeof(value));
+}
+
+int strcmp_P(const char * a, const char * b){
+	return strcmp(a, b);
+}
+
+char * strcpy_P(char * dest, const char * src){
+	return strcpy(dest, src);
+}
+
+size_t strlcpy_P(char * dest, const char * src, size_t size){
+	size_t length = strlen(src);
+	if(size > 0){
+		size_t n = (length < size - 1) ? length : size - 1;
+		memcpy(dest, src, n);
+		dest[n] = 0;
+	}
+	return length;
+}
+
+size_t strlen_P(const char * str){
+	return strlen(str);
+}
+
+// avr-libc uses %S for strings in program memory
+static void convertFormat(char * hostFormat, size_t size, const char * fmt){
+	size_t i = 0;
+	for(; *fmt && i < size - 1; fmt++){
+		hostFormat[i] = (fmt[0] == 'S' && i > 0 && hostFormat[i-1] == '%') ? 's' : fmt[0];
+		i++;
+	}
+	hostFormat[i] = 0;
+}
+
+int vsnprintf_P(char * buffer, size_t size, const char * fmt, va_list args){
+	char hostFormat[256];
+	convertFormat(hostFormat, sizeof(hostFormat), fmt);
+	return vsnprintf(buffer, size, hostFormat, args);
+}
+
+int snprintf_P(char * buffer, size_t size, const char * fmt, ...){
+	va_list args;
+	va_start(args, fmt);
+	int result = vsnprintf_P(buffer, size, fmt, args);
+	va_end(args);
+	return result;
+}
+
+size_t Print::write(const char * str){
+	size_t n = 0;
+	while(*str){
+		n += write((uint8_t) *str++);
+	}
+	return n;
+}
+
+size_t Print::print(const char * str){
+	return write(str);
+}
+
+size_t Print::println(const char * str){
+	return write(str) + write((uint8_t) '\n');
+}
+
+size_t Print::print(char c){
+	return write((uint8_t) c);
+}
+
+size_t Print::print(int n, int base){
+	char str[20];
+	snprintf(str, sizeof(str), (base == 16) ? "%x" : "%d", n);
+	return write(str);
+}
+
+size_t Print::print(unsigned long n, int base){
+	char str[20];
+	snprintf(str, sizeof(str), (base == 16) ? "%lx" : "%lu", n);
+	return write(str);
+}
+
+HostSerial Serial;
+HostUSBDevice USBDevice;
+
+HostSerial::HostSerial(){
+	baud = 57600;
+	pendingLength = 0;
+	pendingIndex = 0;
+	arrivalStart = 0;
+	head = 0;
+	count = 0;
+	overruns = 0;
+	output = 0;
+}
+
+void HostSerial::begin(long baudRate){
+	baud = baudRate;
+}
+
+// Move the characters that have arrived by now into the receive buffer. A character takes 10 bits.
+void HostSerial::receive(void){
+	while(pendingIndex < pendingLength){
+		unsigned long arrival = arrivalStart + (unsigned long) ((pendingIndex + 1) * 10000000.0 / baud);
+		if(arrival > hostMicros){
+			break;
+		}
+		if(count < HOST_SERIAL_BUFFER_SIZE){
+			buffer[(head + count) % HOST_SERIAL_BUFFER_SIZE] = pending[pendingIndex];
+			count++;
+		}
+		else{
+			overruns++;
+		}
+		pendingIndex++;
+	}
+}
+
+void HostSerial::send(const char * str){
+	receive();
+	if(pendingIndex == pendingLength){
+		// nothing on its way, start now
+		pendingIndex = 0;
+		pendingLength = 0;
+		arrivalStart = hostMicros;
+	}
+	while(*str && pendingLength < HOST_SERIAL_MAX_PENDING){
+		pending[pendingLength++] = *str++;
+	}
+}
+
+bool HostSerial::sending(void){
+	receive();
+	return pendingIndex < pendingLength;
+}
+
+int HostSerial::available(void){
+	receive();
+	return count;
+}
+
+int HostSerial::read(void){
+	receive();
+	if(count == 0){
+		return -1;
+	}
+	char c = buffer[head];
+	head = (head + 1) % HOST_SERIAL_BUFFER_SIZE;
+	count--;
+	return (uint8_t) c;
+}
+
+size_t HostSerial::write(uint8_t c){
+	if(output){
+		fputc(c, output);
+	}
+	return 1;
+}
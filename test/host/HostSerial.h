@@ -0,0 +1,54 @@
+/*
+ * Serial port of the host Arduino layer. Characters sent by a test arrive at the baud rate on the clock
+ * of the host layer, which moves with delay() and delayMicroseconds(). The receive buffer has the size
+ * of the buffer in the Arduino core. Characters that arrive when it is full are lost, as on the Arduino.
+ */
+
+#ifndef HOST_SERIAL_H_
+#define HOST_SERIAL_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include "Print.h"
+
+#define HOST_SERIAL_BUFFER_SIZE 64
+#define HOST_SERIAL_MAX_PENDING 4096
+
+class HostSerial : public Print{
+	public:
+	HostSerial();
+	void begin(long baudRate);
+	int available(void);
+	int read(void);
+	size_t write(uint8_t c);
+	using Print::write;
+	
+	// Queue characters to arrive after the ones that are still on their way
+	void send(const char * str);
+	// true while characters are still arriving
+	bool sending(void);
+	// number of characters that were lost because the receive buffer was full
+	uint16_t getOverruns(void){
+		return overruns;
+	}
+	// output of the firmware goes to out, or is discarded when out is 0
+	void setOutput(FILE * out){
+		output = out;
+	}
+	
+	private:
+	void receive(void);
+	
+	long baud;
+	char pending[HOST_SERIAL_MAX_PENDING];
+	uint16_t pendingLength;
+	uint16_t pendingIndex; // next character to arrive
+	unsigned long arrivalStart; // time in microseconds at which pending[0] started to arrive
+	char buffer[HOST_SERIAL_BUFFER_SIZE];
+	uint8_t head;
+	uint8_t count;
+	uint16_t overruns;
+	FILE * output;
+};
+
+#endif /* HOST_SERIAL_H_ */
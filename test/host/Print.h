@@ -0,0 +1,23 @@
+/*
+ * Host version of the Arduino Print class, see Arduino.h in this directory.
+ */
+
+#ifndef HOST_PRINT_H_
+#define HOST_PRINT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+class Print{
+	public:
+	virtual size_t write(uint8_t c) = 0;
+	size_t write(const char * str);
+	size_t print(const char * str);
+	size_t print(char c);
+	size_t print(int n, int base = 10);
+	size_t print(unsigned long n, int base = 10);
+	size_t println(const char * str);
+	virtual ~Print(){}
+};
+
+#endif /* HOST_PRINT_H_ */
@@ -0,0 +1,21 @@
+#ifndef HOST_EEPROM_H_
+#define HOST_EEPROM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// EEPROM in memory, erased (0xFF) at start. Addresses are offsets in the EEPROM.
+#define E2END 1023
+
+void eeprom_read_block(void * dest, const void * src, size_t size);
+void eeprom_update_block(const void * src, void * dest, size_t size);
+uint8_t eeprom_read_byte(const uint8_t * address);
+void eeprom_write_byte(uint8_t * address, uint8_t value);
+void eeprom_update_byte(uint8_t * address, uint8_t value);
+uint16_t eeprom_read_word(const uint16_t * address);
+void eeprom_update_word(uint16_t * address, uint16_t value);
+
+// for the tests: fill the EEPROM with a value
+void hostEepromFill(uint8_t value);
+
+#endif /* HOST_EEPROM_H_ */
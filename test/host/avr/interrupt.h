@@ -0,0 +1,9 @@
+#ifndef HOST_INTERRUPT_H_
+#define HOST_INTERRUPT_H_
+
+// The interrupt routines are compiled, but never called
+#define ISR(vector) extern "C" void vector(void); void vector(void)
+#define cli()
+#define sei()
+
+#endif /* HOST_INTERRUPT_H_ */
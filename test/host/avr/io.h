@@ -0,0 +1,55 @@
+#ifndef HOST_IO_H_
+#define HOST_IO_H_
+
+#include <stdint.h>
+
+// Registers used by the sources that are built for the PC. They are plain variables, see HostArduino.cpp.
+extern volatile uint8_t SREG;
+extern volatile uint8_t SPCR, SPSR, SPDR; // SPSR reads with SPIF set, so a transfer is always complete
+extern volatile uint8_t PINB, PORTB, DDRB, PINC, PORTC, DDRC, PIND, PORTD, DDRD;
+extern volatile uint8_t TCCR0A, TCCR1A, TCCR1B, TIMSK1, TIFR1, TCCR2A, TCCR2B, TCNT2, OCR2A, TIMSK2, TIFR2;
+extern volatile uint16_t TCNT1, OCR1A;
+extern volatile uint8_t MCUSR;
+extern volatile uint8_t EICRB, EIMSK, EIFR, PCICR, PCIFR, PCMSK0, PCMSK1, PCMSK2;
+
+#define SPR0 0
+#define SPR1 1
+#define SPI2X 0
+#define CPHA 2
+#define CPOL 3
+#define MSTR 4
+#define DORD 5
+#define SPE 6
+#define SPIF 7
+
+#define MOSI 16
+#define SCK 17
+#define SS 18
+#define MISO 19
+
+#define CS10 0
+#define CS11 1
+#define WGM12 3
+#define OCIE1A 1
+#define OCF1A 1
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define WGM21 1
+#define OCIE2A 1
+#define OCF2A 1
+#define COM0B1 5
+
+#define PORF 0
+#define EXTRF 1
+#define BORF 2
+#define WDRF 3
+
+#define ISC60 4
+#define ISC61 5
+#define INT6 6
+#define PCIE0 0
+#define PCINT4 4
+#define PCINT5 5
+
+#endif /* HOST_IO_H_ */
@@ -0,0 +1,21 @@
+#ifndef HOST_PGMSPACE_H_
+#define HOST_PGMSPACE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+
+// There is one address space on the PC, program memory is normal memory
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define pgm_read_word(address) (*(const uint16_t *)(address))
+
+int strcmp_P(const char * a, const char * b);
+char * strcpy_P(char * dest, const char * src);
+size_t strlcpy_P(char * dest, const char * src, size_t size);
+size_t strlen_P(const char * str);
+int snprintf_P(char * buffer, size_t size, const char * fmt, ...);
+int vsnprintf_P(char * buffer, size_t size, const char * fmt, va_list args);
+
+#endif /* HOST_PGMSPACE_H_ */
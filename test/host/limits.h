@@ -0,0 +1,16 @@
+/*
+ * int is 16 bits on the AVR. The firmware uses INT_MIN as 'no value' in 16 bit variables and INT_MAX to clamp to
+ * 16 bits, so on the host both get the values of the AVR. The other limits are those of the host.
+ */
+
+#ifndef HOST_LIMITS_H_
+#define HOST_LIMITS_H_
+
+#include_next <limits.h>
+
+#undef INT_MIN
+#undef INT_MAX
+#define INT_MIN (-32767-1)
+#define INT_MAX 32767
+
+#endif /* HOST_LIMITS_H_ */
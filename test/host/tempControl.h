@@ -0,0 +1,2 @@
+// PiLink.cpp includes "tempControl.h", which only works on a file system that ignores case
+#include "TempControl.h"
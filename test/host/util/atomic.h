@@ -0,0 +1,7 @@
+#ifndef HOST_ATOMIC_H_
+#define HOST_ATOMIC_H_
+
+#define ATOMIC_BLOCK(type) for(int atomicOnce = 1; atomicOnce; atomicOnce = 0)
+#define ATOMIC_RESTORESTATE
+
+#endif /* HOST_ATOMIC_H_ */
@@ -0,0 +1,7 @@
+#ifndef HOST_DELAY_H_
+#define HOST_DELAY_H_
+
+void _delay_us(double us);
+void _delay_ms(double ms);
+
+#endif /* HOST_DELAY_H_ */
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2012 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ * 
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "ControlSimulation.h"
+
+#if ONEWIRE_SIMULATION
+
+#include <Arduino.h>
+#include <math.h>
+#include <string.h>
+#include <limits.h>
+#include "DallasTemperature.h"
+#include "TempControl.h"
+#include "Ticks.h"
+#include "pins.h"
+
+#if !TICKS_VIRTUAL
+#error "The control simulation needs the virtual clock, set TICKS_VIRTUAL to 1"
+#endif
+
+// The main loop polls the sensors many times per second. Polling every 50ms is enough to collect each reading.
+#define SIMULATION_POLL_INTERVAL 50
+
+ControlSimulation::ControlSimulation(ThermalSim & thermalSim) :
+	plant(thermalSim),
+	beerProbe(DS18B20MODEL, 0x0B0B),
+	fridgeProbe(DS18B20MODEL, 0x0F0F){
+	memset(&result, 0, sizeof(result));
+	cooling = false;
+	heating = false;
+	reachedSetting = false;
+}
+
+void ControlSimulation::init(void){
+	OneWireSimBus::forPin(beerSensorPin)->attach(&beerProbe);
+	OneWireSimBus::forPin(fridgeSensorPin)->attach(&fridgeProbe);
+	setProbeTemperatures();
+	setDoorOpen(false);
+	
+	tempControl.loadSettingsAndConstants();
+	tempControl.init();
+	tempControl.updatePID();
+	tempControl.updateState();
+}
+
+void ControlSimulation::setDoorOpen(bool open){
+	plant.setDoorOpen(open);
+	digitalWrite(doorPin, open ? LOW : HIGH); // the door switch pulls the pin low when the door is open
+}
+
+void ControlSimulation::setProbeTemperatures(void){
+	// the probes have a resolution of 1/16 degree
+	beerProbe.setTemperature((int16_t) floor(plant.getBeer() * 16 + 0.5));
+	fridgeProbe.setTemperature((int16_t) floor(plant.getFridge() * 16 + 0.5));
+}
+
+void ControlSimulation::run(uint32_t seconds, FILE * log, uint16_t logInterval){
+	if(log != 0 && result.seconds == 0){
+		fprintf(log, "time,beer,fridge,beerSensor,fridgeSensor,beerSetting,fridgeSetting,state,cooling,heating\n");
+	}
+	for(uint32_t i = 0; i < seconds; i++){
+		second();
+		if(log != 0 && logInterval != 0 && result.seconds % logInterval == 0){
+			fprintf(log, "%lu,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%d,%d,%d\n",
+				(unsigned long) result.seconds, plant.getBeer(), plant.getFridge(),
+				tempControl.getBeerTemp() / 512.0, tempControl.getFridgeTemp() / 512.0,
+				tempControl.getBeerSetting() / 512.0, tempControl.getFridgeSetting() / 512.0,
+				tempControl.getState(), cooling, heating);
+		}
+	}
+}
+
+void ControlSimulation::second(void){
+	// poll the sensors during the second, like the main loop
+	for(uint16_t t = 0; t < 1000; t += SIMULATION_POLL_INTERVAL){
+		Ticks::advance(SIMULATION_POLL_INTERVAL);
+		tempControl.pollSensors();
+	}
+	tempControl.updateTemperatures();
+	tempControl.detectPeaks();
+	tempControl.updatePID();
+	tempControl.updateState();
+	tempControl.updateOutputs();
+	
+	// outputs are inverted on the shield
+	bool newCooling = digitalRead(coolingPin) == LOW;
+	bool newHeating = digitalRead(heatingPin) == LOW;
+	if(newCooling && !cooling){
+		result.compressorStarts++;
+	}
+	if(newHeating && !heating){
+		result.heaterStarts++;
+	}
+	cooling = newCooling;
+	heating = newHeating;
+	
+	plant.step(1, cooling, heating);
+	setProbeTemperatures();
+	record();
+}
+
+void ControlSimulation::record(void){
+	result.seconds++;
+	if(cooling){
+		result.compressorSeconds++;
+	}
+	if(heating){
+		result.heaterSeconds++;
+	}
+	fixed7_9 setting = tempControl.getBeerSetting();
+	if(setting == INT_MIN){
+		return; // fridge constant mode, no beer setting
+	}
+	double error = plant.getBeer() - setting / 512.0;
+	if(fabs(error) <= SIMULATION_BAND / 512.0){
+		result.secondsInBand++;
+	}
+	if(!reachedSetting){
+		// the first approach of the setting is not overshoot
+		reachedSetting = fabs(error) < 0.05;
+		return;
+	}
+	if(error > result.maxOvershoot){
+		result.maxOvershoot = error;
+	}
+	if(-error > result.maxUndershoot){
+		result.maxUndershoot = -error;
+	}
+}
+
+void ControlSimulation::printSummary(FILE * out){
+	fprintf(out, "simulated time:    %.1f days\n", result.seconds / 86400.0);
+	fprintf(out, "time in band:      %.1f%% (+/- %.2f degree)\n", result.seconds ? 100.0 * result.secondsInBand / result.seconds : 0.0, SIMULATION_BAND / 512.0);
+	fprintf(out, "max overshoot:     %.3f degree\n", result.maxOvershoot);
+	fprintf(out, "max undershoot:    %.3f degree\n", result.maxUndershoot);
+	fprintf(out, "compressor starts: %u, on %.1f hours\n", result.compressorStarts, result.compressorSeconds / 3600.0);
+	fprintf(out, "heater starts:     %u, on %.1f hours\n", result.heaterStarts, result.heaterSeconds / 3600.0);
+}
+
+#endif // ONEWIRE_SIMULATION
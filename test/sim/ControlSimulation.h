@@ -0,0 +1,99 @@
+/*
+ * Copyright 2012 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ * 
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CONTROLSIMULATION_H_
+#define CONTROLSIMULATION_H_
+
+#include "OneWire.h"
+
+#if ONEWIRE_SIMULATION
+
+#include <stdio.h>
+#include "OneWireSim.h"
+#include "ThermalSim.h"
+#include "temperatureFormats.h"
+
+// Beer temperatures within this distance of the beer setting are in the band, 0.5 degree
+#define SIMULATION_BAND 256
+
+struct ControlSimulationResult{
+	uint32_t seconds; // simulated time
+	uint32_t secondsInBand; // seconds with the beer within SIMULATION_BAND of the setting
+	double maxOvershoot; // highest beer temperature above the setting, after the beer first reached the setting
+	double maxUndershoot; // same, below the setting
+	uint16_t compressorStarts;
+	uint16_t heaterStarts;
+	uint32_t compressorSeconds;
+	uint32_t heaterSeconds;
+};
+
+/* Runs the temperature control against a ThermalSim, on a virtual clock, for testing on a PC.
+ * Each simulated second runs the same sequence as the main loop: updateTemperatures, detectPeaks, updatePID,
+ * updateState and updateOutputs, and the sensors are polled in between. The sensors are simulated 1-Wire devices,
+ * so the complete sensor code is used. Two weeks of fermentation take seconds.
+ *
+ * Build for a host platform, with TICKS_VIRTUAL set to 1. The host platform has to provide the Arduino functions
+ * that are used, EEPROM in memory and a digitalRead that returns the last value written to a pin: the simulation
+ * reads the outputs from the cooling and heating pins and opens the door by writing the door pin.
+ * The host layer in test/host does. Example, as in test/FermentationSim.cpp:
+ *	ThermalSim plant;
+ *	plant.setFermentation(15, 2*86400L, 86400L); // 15W at day 2
+ *	ControlSimulation simulation(plant);
+ *	simulation.init();
+ *	tempControl.setBeerTemp(18<<9);
+ *	simulation.run(14*86400L, stdout, 60); // one line per minute
+ *	simulation.printSummary(stdout);
+ */
+class ControlSimulation{
+	public:
+	ControlSimulation(ThermalSim & thermalSim);
+	
+	// attach the simulated sensors and start the temperature control as setup() does
+	void init(void);
+	
+	// Run for a number of seconds. Writes a line of comma separated values every logInterval seconds
+	// to log, when log is not 0.
+	void run(uint32_t seconds, FILE * log, uint16_t logInterval);
+	
+	void setDoorOpen(bool open);
+	
+	const ControlSimulationResult & getResult(void){
+		return result;
+	}
+	
+	void printSummary(FILE * out);
+	
+	private:
+	void second(void);
+	void record(void);
+	void setProbeTemperatures(void);
+	
+	ThermalSim & plant;
+	OneWireSimDevice beerProbe;
+	OneWireSimDevice fridgeProbe;
+	ControlSimulationResult result;
+	bool cooling;
+	bool heating;
+	bool reachedSetting;
+};
+
+#endif // ONEWIRE_SIMULATION
+
+#endif /* CONTROLSIMULATION_H_ */
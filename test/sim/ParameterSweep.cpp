@@ -0,0 +1,323 @@
+/*
+ * Copyright 2012 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ * 
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "ParameterSweep.h"
+
+#if ONEWIRE_SIMULATION
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "temperatureFormats.h"
+#include "ThermalSim.h"
+#include "jsonKeys.h"
+
+// Candidates with the beer in the band less than this percentage of the time are not ranked.
+// They might not reach the setting at all, which would show as no overshoot.
+#define SWEEP_MIN_TIME_IN_BAND 80
+
+enum sweepParameterTypes{
+	SWEEP_FIXED_POINT, // fixed7_9
+	SWEEP_TEMP_DIFF, // fixed7_9 temperature difference
+	SWEEP_FILTER // uint8_t b value
+};
+
+// A constant that is searched, in ControlConstants at offset. Values are from min to max, inclusive.
+struct SweepParameter{
+	const char * key;
+	uint8_t type;
+	size_t offset;
+	int16_t min;
+	int16_t max;
+};
+
+static const SweepParameter parameters[] = {
+	{JSONKEY_Kp, SWEEP_FIXED_POINT, offsetof(ControlConstants, Kp), 2*512, 40*512},
+	{JSONKEY_Ki, SWEEP_FIXED_POINT, offsetof(ControlConstants, Ki), 0, 2*512},
+	{JSONKEY_Kd, SWEEP_FIXED_POINT, offsetof(ControlConstants, Kd), -10*512, 0},
+	{JSONKEY_idleRangeHigh, SWEEP_TEMP_DIFF, offsetof(ControlConstants, idleRangeHigh), 128, 1024},
+	{JSONKEY_idleRangeLow, SWEEP_TEMP_DIFF, offsetof(ControlConstants, idleRangeLow), -1024, -128},
+	{JSONKEY_heatingTargetUpper, SWEEP_TEMP_DIFF, offsetof(ControlConstants, heatingTargetUpper), 0, 256},
+	{JSONKEY_heatingTargetLower, SWEEP_TEMP_DIFF, offsetof(ControlConstants, heatingTargetLower), -256, 0},
+	{JSONKEY_coolingTargetUpper, SWEEP_TEMP_DIFF, offsetof(ControlConstants, coolingTargetUpper), 0, 256},
+	{JSONKEY_coolingTargetLower, SWEEP_TEMP_DIFF, offsetof(ControlConstants, coolingTargetLower), -256, 0},
+	{JSONKEY_fridgeFastFilter, SWEEP_FILTER, offsetof(ControlConstants, fridgeFastFilter), 0, 3},
+	{JSONKEY_fridgeSlowFilter, SWEEP_FILTER, offsetof(ControlConstants, fridgeSlowFilter), 2, 6},
+	{JSONKEY_beerSlowFilter, SWEEP_FILTER, offsetof(ControlConstants, beerSlowFilter), 2, 6},
+	{JSONKEY_beerSlopeFilter, SWEEP_FILTER, offsetof(ControlConstants, beerSlopeFilter), 2, 6},
+};
+
+#define NUM_SWEEP_PARAMETERS (sizeof(parameters)/sizeof(parameters[0]))
+
+ParameterSweep::ParameterSweep(const SweepScenario & sweepScenario) : scenario(sweepScenario){
+	results = 0;
+	ranking = 0;
+	numResults = 0;
+	numRanked = 0;
+}
+
+ParameterSweep::~ParameterSweep(){
+	free(results);
+	free(ranking);
+}
+
+SweepScenario ParameterSweep::defaultScenario(void){
+	SweepScenario s;
+	s.ambient = 22;
+	s.startTemperature = 20;
+	s.beerSetting = 18*512;
+	s.fermentationPeak = 15; // an active fermentation of 20 liters
+	s.fermentationPeakTime = 2*86400.0;
+	s.fermentationWidth = 86400.0;
+	s.seconds = 7*86400L;
+	return s;
+}
+
+void ParameterSweep::randomCandidate(ControlConstants & constants){
+	for(uint8_t i=0; i<NUM_SWEEP_PARAMETERS; i++){
+		const SweepParameter & p = parameters[i];
+		int16_t value = p.min + rand() % (p.max - p.min + 1);
+		char * field = (char *) &constants + p.offset;
+		if(p.type == SWEEP_FILTER){
+			*(uint8_t *) field = value;
+		}
+		else{
+			*(fixed7_9 *) field = value;
+		}
+	}
+}
+
+// runs in the child process
+void ParameterSweep::simulate(const ControlConstants & constants, int fd){
+	ThermalSim plant;
+	plant.init(scenario.startTemperature);
+	plant.setAmbient(scenario.ambient);
+	plant.setFermentation(scenario.fermentationPeak, scenario.fermentationPeakTime, scenario.fermentationWidth);
+	ControlSimulation simulation(plant);
+	simulation.init();
+	
+	tempControl.cc = constants;
+	tempControl.storeConstants();
+	tempControl.loadConstants(); // applies the filter settings to the sensors
+	tempControl.setBeerTemp(scenario.beerSetting);
+	simulation.run(scenario.seconds, 0, 0);
+	
+	const ControlSimulationResult & result = simulation.getResult();
+	if(write(fd, &result, sizeof(result)) != sizeof(result)){
+		_exit(1);
+	}
+}
+
+bool ParameterSweep::run(uint16_t count, uint8_t workers, unsigned int seed){
+	free(results);
+	free(ranking);
+	results = (SweepResult *) calloc(count, sizeof(SweepResult));
+	ranking = (uint16_t *) calloc(count, sizeof(uint16_t));
+	pid_t * pids = (pid_t *) calloc(workers, sizeof(pid_t));
+	int * pipes = (int *) calloc(workers, sizeof(int));
+	uint16_t * jobs = (uint16_t *) calloc(workers, sizeof(uint16_t));
+	numResults = 0;
+	numRanked = 0;
+	if(results == 0 || ranking == 0 || pids == 0 || pipes == 0 || jobs == 0 || workers == 0){
+		free(pids);
+		free(pipes);
+		free(jobs);
+		return false;
+	}
+	numResults = count;
+	
+	// every candidate starts from the default constants
+	tempControl.loadDefaultConstants();
+	srand(seed);
+	for(uint16_t i=0; i<count; i++){
+		results[i].constants = tempControl.cc;
+		randomCandidate(results[i].constants);
+	}
+	
+	fflush(0); // buffered output would be written again by the children
+	uint16_t next = 0;
+	uint8_t running = 0;
+	while(next < count || running > 0){
+		if(next < count && running < workers){
+			uint8_t slot = 0;
+			while(pids[slot] != 0){
+				slot++;
+			}
+			int fds[2];
+			if(pipe(fds) != 0){
+				next++; // skip this candidate, it is not done
+				continue;
+			}
+			pid_t pid = fork();
+			if(pid == 0){
+				close(fds[0]);
+				simulate(results[next].constants, fds[1]);
+				_exit(0);
+			}
+			close(fds[1]);
+			if(pid < 0){
+				close(fds[0]);
+				next++;
+				continue;
+			}
+			pids[slot] = pid;
+			pipes[slot] = fds[0];
+			jobs[slot] = next;
+			next++;
+			running++;
+			continue;
+		}
+		int status;
+		pid_t pid = waitpid(-1, &status, 0); // wait() is hidden by the Delay object (see Ticks.h)
+		if(pid < 0){
+			break; // no children left
+		}
+		for(uint8_t slot=0; slot<workers; slot++){
+			if(pids[slot] != pid){
+				continue;
+			}
+			SweepResult & result = results[jobs[slot]];
+			result.done = read(pipes[slot], &result.simulation, sizeof(result.simulation)) == sizeof(result.simulation);
+			close(pipes[slot]);
+			pids[slot] = 0;
+			running--;
+		}
+	}
+	free(pids);
+	free(pipes);
+	free(jobs);
+	findPareto();
+	return true;
+}
+
+double ParameterSweep::overshoot(const SweepResult & result){
+	return max(result.simulation.maxOvershoot, result.simulation.maxUndershoot);
+}
+
+void ParameterSweep::findPareto(void){
+	numRanked = 0;
+	for(uint16_t i=0; i<numResults; i++){
+		SweepResult & a = results[i];
+		a.pareto = false;
+		if(!a.done || a.simulation.secondsInBand * 100 < (uint32_t) SWEEP_MIN_TIME_IN_BAND * a.simulation.seconds){
+			continue;
+		}
+		bool dominated = false;
+		for(uint16_t j=0; j<numResults && !dominated; j++){
+			SweepResult & b = results[j];
+			if(j == i || !b.done || b.simulation.secondsInBand * 100 < (uint32_t) SWEEP_MIN_TIME_IN_BAND * b.simulation.seconds){
+				continue;
+			}
+			bool noWorse = overshoot(b) <= overshoot(a) && b.simulation.compressorStarts <= a.simulation.compressorStarts;
+			bool better = overshoot(b) < overshoot(a) || b.simulation.compressorStarts < a.simulation.compressorStarts;
+			dominated = noWorse && better;
+		}
+		if(dominated){
+			continue;
+		}
+		a.pareto = true;
+		// insert in order of overshoot
+		uint16_t pos = numRanked++;
+		while(pos > 0 && overshoot(results[ranking[pos-1]]) > overshoot(a)){
+			ranking[pos] = ranking[pos-1];
+			pos--;
+		}
+		ranking[pos] = i;
+	}
+}
+
+// "key":"value" of parameter i
+static void parameterToString(char * pair, size_t size, uint8_t i, const ControlConstants & constants){
+	char valueString[12];
+	const SweepParameter & p = parameters[i];
+	const char * field = (const char *) &constants + p.offset;
+	switch(p.type){
+		case SWEEP_FIXED_POINT:
+			fixedPointToString(valueString, *(const fixed7_9 *) field, 3, 12);
+			break;
+		case SWEEP_TEMP_DIFF:
+			tempDiffToString(valueString, *(const fixed7_9 *) field, 3, 12);
+			break;
+		default:
+			snprintf(valueString, sizeof(valueString), "%u", *(const uint8_t *) field);
+			break;
+	}
+	snprintf(pair, size, "\"%s\":\"%s\"", p.key, valueString);
+}
+
+void ParameterSweep::writeSettings(FILE * out, const ControlConstants & constants){
+	char pair[SWEEP_COMMAND_LENGTH];
+	fputc('{', out);
+	for(uint8_t i=0; i<NUM_SWEEP_PARAMETERS; i++){
+		parameterToString(pair, sizeof(pair), i, constants);
+		fprintf(out, "%s%s", (i == 0) ? "" : ",", pair);
+	}
+	fputc('}', out);
+}
+
+void ParameterSweep::writeRanking(FILE * out){
+	char tempFormat = tempControl.cc.tempFormat;
+	tempControl.cc.tempFormat = 'C'; // used by tempDiffToString, restored at the end
+	fprintf(out, "[\n");
+	for(uint16_t rank=0; rank<numRanked; rank++){
+		const SweepResult & r = results[ranking[rank]];
+		fprintf(out, "{\"rank\":%u,\"overshoot\":%.3f,\"maxOvershoot\":%.3f,\"maxUndershoot\":%.3f,"
+			"\"compressorStarts\":%u,\"heaterStarts\":%u,\"timeInBand\":%.1f,\"settings\":",
+			rank + 1, overshoot(r), r.simulation.maxOvershoot, r.simulation.maxUndershoot,
+			r.simulation.compressorStarts, r.simulation.heaterStarts,
+			r.simulation.seconds ? 100.0 * r.simulation.secondsInBand / r.simulation.seconds : 0.0);
+		writeSettings(out, r.constants);
+		fprintf(out, "}%s\n", (rank + 1 < numRanked) ? "," : "");
+	}
+	fprintf(out, "]\n");
+	tempControl.cc.tempFormat = tempFormat;
+}
+
+void ParameterSweep::writeCommands(FILE * out, uint16_t rank, char tempFormat){
+	char controlFormat = tempControl.cc.tempFormat;
+	tempControl.cc.tempFormat = tempFormat; // used by tempDiffToString, restored at the end
+	const ControlConstants & constants = results[ranking[rank]].constants;
+	char pair[SWEEP_COMMAND_LENGTH];
+	size_t lineLength = 0;
+	for(uint8_t i=0; i<NUM_SWEEP_PARAMETERS; i++){
+		parameterToString(pair, sizeof(pair), i, constants);
+		// a line is j{pairs}, the newline and a comma between the pairs
+		if(lineLength != 0 && lineLength + 1 + strlen(pair) + 2 > SWEEP_COMMAND_LENGTH){
+			fputs("}\n", out);
+			lineLength = 0;
+		}
+		if(lineLength == 0){
+			fputs("j{", out);
+			lineLength = 2;
+		}
+		else{
+			fputc(',', out);
+			lineLength++;
+		}
+		fputs(pair, out);
+		lineLength += strlen(pair);
+	}
+	fputs("}\n", out);
+	tempControl.cc.tempFormat = controlFormat;
+}
+
+#endif // ONEWIRE_SIMULATION
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2012 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ * 
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PARAMETERSWEEP_H_
+#define PARAMETERSWEEP_H_
+
+#include "OneWire.h"
+
+#if ONEWIRE_SIMULATION
+
+#include <stdio.h>
+#include "ControlSimulation.h"
+#include "TempControl.h"
+
+// Longest line that writeCommands writes, with the newline. A line fits in the 64 byte receive buffer of the Arduino.
+// receiveJson reads about one character per ms, slower than they arrive at 57600 baud, so longer lines lose characters.
+#define SWEEP_COMMAND_LENGTH 64
+
+// The fermentation that is simulated for each candidate
+struct SweepScenario{
+	double ambient;
+	double startTemperature; // of the beer and the fridge
+	fixed7_9 beerSetting;
+	double fermentationPeak; // watts
+	double fermentationPeakTime; // seconds
+	double fermentationWidth; // seconds
+	uint32_t seconds; // length of the simulation
+};
+
+// Result of one candidate
+struct SweepResult{
+	ControlConstants constants;
+	ControlSimulationResult simulation;
+	bool done; // false when the simulation did not finish
+	bool pareto; // no other candidate has both less overshoot and fewer compressor starts
+};
+
+/* ParameterSweep searches ControlConstants for settings with little overshoot and few compressor starts.
+ * It simulates a fermentation for each candidate with ControlSimulation, and ranks the candidates that are not
+ * beaten on both counts by another candidate: the Pareto set. The overshoot is the largest deviation of the beer
+ * from its setting, above or below, after the beer first reached the setting.
+ * The candidates are random within the ranges in ParameterSweep.cpp. Each starts from the default constants.
+ *
+ * The temperature control is a static class, so one process can only run one controller. Each candidate runs in a
+ * child process (fork), starting from the state of the parent, and up to 'workers' children run at the same time.
+ * Host only (POSIX), build like ControlSimulation. Example:
+ *	SweepScenario scenario = ParameterSweep::defaultScenario();
+ *	ParameterSweep sweep(scenario);
+ *	sweep.run(2000, 8, 1); // 2000 candidates on 8 cores, random seed 1
+ *	sweep.writeRanking(stdout);
+ *	sweep.writeCommands(commandFile, 0, 'C'); // the settings of the best candidate
+ */
+class ParameterSweep{
+	public:
+	ParameterSweep(const SweepScenario & sweepScenario);
+	~ParameterSweep();
+	
+	static SweepScenario defaultScenario(void);
+	
+	// simulate count random candidates. Returns false if the results could not be allocated.
+	bool run(uint16_t count, uint8_t workers, unsigned int seed);
+	
+	// the Pareto set as a JSON array, lowest overshoot first, with the simulation results
+	void writeRanking(FILE * out);
+	
+	// The settings of one candidate of the Pareto set (rank 0 is the first) as 'j' commands, a few settings per line
+	// and at most SWEEP_COMMAND_LENGTH characters per line. Send the lines one at a time, waiting for the reply of the
+	// controller to each. Temperature differences are written in tempFormat ('C' or 'F'), the format the controller uses.
+	void writeCommands(FILE * out, uint16_t rank, char tempFormat);
+	
+	uint16_t getNumRanked(void){
+		return numRanked;
+	}
+	
+	// the result of rank, 0 to getNumRanked() - 1
+	const SweepResult & getRanked(uint16_t rank){
+		return results[ranking[rank]];
+	}
+	
+	// the searched constants as a JSON object. Temperature differences are in the format of tempControl.
+	static void writeSettings(FILE * out, const ControlConstants & constants);
+	
+	private:
+	void randomCandidate(ControlConstants & constants);
+	void simulate(const ControlConstants & constants, int fd);
+	void findPareto(void);
+	static double overshoot(const SweepResult & result);
+	
+	SweepScenario scenario;
+	SweepResult * results;
+	uint16_t * ranking; // indexes of the Pareto set in results, lowest overshoot first
+	uint16_t numResults;
+	uint16_t numRanked;
+};
+
+#endif // ONEWIRE_SIMULATION
+
+#endif /* PARAMETERSWEEP_H_ */
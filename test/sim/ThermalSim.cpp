@@ -0,0 +1,75 @@
+/*
+ * Copyright 2012 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ * 
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "ThermalSim.h"
+#include <math.h>
+
+ThermalSim::ThermalSim(){
+	params.beerCapacity = 20 * 4180.0; // 20 liters of water
+	params.airCapacity = 4000;
+	params.evaporatorCapacity = 1000;
+	params.heaterCapacity = 200;
+	params.beerToAir = 5; // time constant of the beer about 4.6 hours
+	params.airToAmbient = 1.5;
+	params.doorToAmbient = 20;
+	params.evaporatorToAir = 15;
+	params.heaterToAir = 5;
+	params.coolingPower = 120;
+	params.heatingPower = 100;
+	fermentationPeak = 0;
+	fermentationTime = 0;
+	fermentationWidth = 1;
+	doorOpen = false;
+	init(20);
+}
+
+void ThermalSim::init(double temperature){
+	beer = temperature;
+	air = temperature;
+	evaporator = temperature;
+	heater = temperature;
+	ambient = temperature;
+	time = 0;
+}
+
+void ThermalSim::setFermentation(double peakPower, double peakTime, double width){
+	fermentationPeak = peakPower;
+	fermentationTime = peakTime;
+	fermentationWidth = width;
+}
+
+double ThermalSim::getFermentationPower(void){
+	double x = (time - fermentationTime) / fermentationWidth;
+	return fermentationPeak * pow(0.25, x * x);
+}
+
+void ThermalSim::step(double seconds, bool cooling, bool heating){
+	// heat flows in watts
+	double beerFlow = params.beerToAir * (air - beer);
+	double ambientFlow = (params.airToAmbient + (doorOpen ? params.doorToAmbient : 0)) * (ambient - air);
+	double evaporatorFlow = params.evaporatorToAir * (air - evaporator);
+	double heaterFlow = params.heaterToAir * (heater - air);
+	
+	beer += seconds * (beerFlow + getFermentationPower()) / params.beerCapacity;
+	air += seconds * (ambientFlow - beerFlow - evaporatorFlow + heaterFlow) / params.airCapacity;
+	evaporator += seconds * (evaporatorFlow - (cooling ? params.coolingPower : 0)) / params.evaporatorCapacity;
+	heater += seconds * ((heating ? params.heatingPower : 0) - heaterFlow) / params.heaterCapacity;
+	time += seconds;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2012 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ * 
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef THERMALSIM_H_
+#define THERMALSIM_H_
+
+#include <inttypes.h>
+
+// Physical constants of the simulated fridge, in J/K, W/K and W. The defaults are a 20 liter
+// fermentation in a small fridge with a 100W heater.
+struct ThermalSimParams{
+	double beerCapacity; // beer and fermenter
+	double airCapacity; // air, shelves and walls inside the fridge
+	double evaporatorCapacity;
+	double heaterCapacity;
+	double beerToAir; // heat transfer between beer and fridge air
+	double airToAmbient; // through the insulation
+	double doorToAmbient; // extra heat transfer while the door is open
+	double evaporatorToAir;
+	double heaterToAir;
+	double coolingPower; // heat removed from the evaporator while the compressor runs
+	double heatingPower;
+};
+
+/* Lumped capacitance model of beer in a fridge in a room. Each part has one temperature:
+ * the beer, the fridge air, the evaporator and the heater. The compressor cools the evaporator, which
+ * cools the air, so the fridge keeps cooling for a while after the compressor stops. The heater has the same lag.
+ * Fermentation adds heat to the beer, with a bell shaped curve in time.
+ * Temperatures are in degrees Celsius, time in seconds. This runs on the host only: it uses floating point.
+ */
+class ThermalSim{
+	public:
+	ThermalSim();
+	
+	ThermalSimParams params;
+	
+	// set all parts to the same temperature
+	void init(double temperature);
+	
+	void setAmbient(double temperature){
+		ambient = temperature;
+	}
+	
+	void setDoorOpen(bool open){
+		doorOpen = open;
+	}
+	
+	// Fermentation heat: peakPower watts at peakTime, falling to a quarter of the peak at peakTime +/- width.
+	void setFermentation(double peakPower, double peakTime, double width);
+	
+	// advance the model, with the compressor and heater in the given state
+	void step(double seconds, bool cooling, bool heating);
+	
+	double getBeer(void){
+		return beer;
+	}
+	double getFridge(void){
+		return air;
+	}
+	double getAmbient(void){
+		return ambient;
+	}
+	double getFermentationPower(void);
+	double getTime(void){
+		return time;
+	}
+	
+	private:
+	double beer;
+	double air;
+	double evaporator;
+	double heater;
+	double ambient;
+	double time;
+	double fermentationPeak;
+	double fermentationTime;
+	double fermentationWidth;
+	bool doorOpen;
+};
+
+#endif /* THERMALSIM_H_ */